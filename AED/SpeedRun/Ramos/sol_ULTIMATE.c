@@ -411,6 +411,263 @@ static void solve_4(int final_position) {
 
 
 
+//
+// FUNC A*
+//
+//  Pesquisa "best-first": cada estado (posição,velocidade) é expandido por ordem de
+// movimentos feitos + estimativa dos movimentos que faltam. A estimativa é o número exato de
+// movimentos que faltariam se a estrada não tivesse limites de velocidade, por isso nunca é maior
+// do que o valor real e o primeiro estado final que sai da fila já é ótimo.
+//
+
+static solution_t solution_5_best;
+static double solution_5_elapsed_time; // time it took to solve the problem
+static unsigned long solution_5_count; // effort dispended solving the problem
+
+#define _no_path_  1000000
+
+static int estimativa_pronta = 0;
+static int estimativa[1 + _max_road_size_][1 + _max_road_speed_]; // movimentos que faltam para andar d posições (sem limites), começando à velocidade v
+static int saltos_5[1 + _max_road_size_][1 + _max_road_speed_];     // numero de movimentos com que se chegou a cada estado (-1 se ainda não)
+static int anterior_5[1 + _max_road_size_][1 + _max_road_speed_];   // velocidade do estado anterior
+
+typedef struct
+{
+  int f,g,position,speed;
+}
+heap_entry_t;
+
+static heap_entry_t heap_5[3 * (1 + _max_road_size_) * (1 + _max_road_speed_)];
+static int heap_5_size;
+
+#define heap_before(a,b)  ((a).f < (b).f || ((a).f == (b).f && (a).g > (b).g))
+
+static void heap_5_push(heap_entry_t e)
+{
+  int i;
+
+  for(i = heap_5_size++;i > 0 && heap_before(e,heap_5[(i - 1) / 2]);i = (i - 1) / 2)
+    heap_5[i] = heap_5[(i - 1) / 2];
+  heap_5[i] = e;
+}
+
+static heap_entry_t heap_5_pop(void)
+{
+  heap_entry_t top = heap_5[0],last = heap_5[--heap_5_size];
+  int i,j;
+
+  for(i = 0;(j = 2 * i + 1) < heap_5_size;i = j)
+  {
+    if(j + 1 < heap_5_size && heap_before(heap_5[j + 1],heap_5[j]))
+      j++;
+    if(!heap_before(heap_5[j],last))
+      break;
+    heap_5[i] = heap_5[j];
+  }
+  heap_5[i] = last;
+  return top;
+}
+
+static void init_estimativa(void)
+{
+  int d,v,w,best;
+
+  for(d = 0;d <= _max_road_size_;d++)
+    for(v = 0;v <= _max_road_speed_;v++)
+    {
+      best = (d == 0 && v == 1) ? -1 : _no_path_;
+      for(w = v - 1;d > 0 && w <= v + 1;w++)
+        if(w >= 1 && w <= _max_road_speed_ && w <= d && estimativa[d - w][w] < best)
+          best = estimativa[d - w][w];
+      estimativa[d][v] = (best < _no_path_) ? best + 1 : _no_path_;
+    }
+}
+
+static void solve_5(int final_position)
+{
+  heap_entry_t e,n;
+  int i,new_speed,position,speed;
+
+  if(final_position < 1 || final_position > _max_road_size_)
+  {
+    fprintf(stderr,"solve_5: bad final_position\n");
+    exit(1);
+  }
+  solution_5_elapsed_time = cpu_time();
+  solution_5_count = 0ul;
+  solution_5_best.n_moves = final_position + 100;
+  if(estimativa_pronta == 0)
+  {
+    init_estimativa();
+    estimativa_pronta = 1;
+  }
+  for(position = 0;position <= final_position;position++)
+    for(speed = 0;speed <= _max_road_speed_;speed++)
+      saltos_5[position][speed] = -1;
+  heap_5_size = 0;
+  saltos_5[0][0] = 0;
+  e.g = e.position = e.speed = 0;
+  e.f = estimativa[final_position][0];
+  heap_5_push(e);
+  while(heap_5_size > 0)
+  {
+    e = heap_5_pop();
+    if(e.g != saltos_5[e.position][e.speed])
+      continue; // já foi encontrado um caminho mais curto para este estado
+    solution_5_count++;
+    if(e.position == final_position && e.speed == 1)
+    {
+      solution_5_best.n_moves = e.g;
+      for(position = final_position,speed = 1,i = e.g;i >= 0;i--)
+      {
+        solution_5_best.positions[i] = position;
+        new_speed = anterior_5[position][speed];
+        position -= speed;
+        speed = new_speed;
+      }
+      break;
+    }
+    for(new_speed = e.speed + 1;new_speed >= e.speed - 1;new_speed--)
+      if(new_speed >= 1 && new_speed <= _max_road_speed_ && e.position + new_speed <= final_position)
+      {
+        for(i = 0;i <= new_speed && new_speed <= max_road_speed[e.position + i];i++);
+        if(i <= new_speed)
+          continue;
+        n.position = e.position + new_speed;
+        n.speed = new_speed;
+        n.g = e.g + 1;
+        if(estimativa[final_position - n.position][n.speed] >= _no_path_)
+          continue;
+        if(saltos_5[n.position][n.speed] >= 0 && saltos_5[n.position][n.speed] <= n.g)
+          continue;
+        saltos_5[n.position][n.speed] = n.g;
+        anterior_5[n.position][n.speed] = e.speed;
+        n.f = n.g + estimativa[final_position - n.position][n.speed];
+        heap_5_push(n);
+      }
+  }
+  solution_5_elapsed_time = cpu_time() - solution_5_elapsed_time;
+}
+
+#undef heap_before
+
+
+
+//
+// FUNC BIDIRECIONAL
+//
+//  Duas pesquisas em largura, uma a partir de (0,0) e outra para trás a partir de
+// (final_position,1), expandindo sempre uma camada inteira da fronteira mais pequena. Pára quando
+// o melhor caminho encontrado pelo encontro das duas não for maior do que a soma das profundidades.
+//
+
+static solution_t solution_6_best;
+static double solution_6_elapsed_time; // time it took to solve the problem
+static unsigned long solution_6_count; // effort dispended solving the problem
+
+static int dist_6[2][1 + _max_road_size_][1 + _max_road_speed_];  // [0] movimentos desde o início, [1] movimentos até ao fim (-1 se ainda não)
+static int ligacao_6[2][1 + _max_road_size_][1 + _max_road_speed_]; // [0] velocidade do estado anterior, [1] velocidade do estado seguinte
+static int fila_6[2][(1 + _max_road_size_) * (1 + _max_road_speed_)][2];
+
+static void solve_6(int final_position)
+{
+  int inicio[2],fim[2],profundidade[2],best,meet_position,meet_speed,lado,outro,ultimo;
+  int i,position,speed,new_speed,p;
+
+  if(final_position < 1 || final_position > _max_road_size_)
+  {
+    fprintf(stderr,"solve_6: bad final_position\n");
+    exit(1);
+  }
+  solution_6_elapsed_time = cpu_time();
+  solution_6_count = 0ul;
+  solution_6_best.n_moves = final_position + 100;
+  for(lado = 0;lado < 2;lado++)
+  {
+    for(position = 0;position <= final_position;position++)
+      for(speed = 0;speed <= _max_road_speed_;speed++)
+        dist_6[lado][position][speed] = -1;
+    inicio[lado] = profundidade[lado] = 0;
+    fim[lado] = 1;
+    fila_6[lado][0][0] = (lado == 0) ? 0 : final_position;
+    fila_6[lado][0][1] = (lado == 0) ? 0 : 1;
+  }
+  dist_6[0][0][0] = 0;
+  dist_6[1][final_position][1] = 0;
+  best = _no_path_;
+  meet_position = meet_speed = 0;
+  while(inicio[0] < fim[0] && inicio[1] < fim[1] && best > profundidade[0] + profundidade[1])
+  {
+    lado = (fim[0] - inicio[0] <= fim[1] - inicio[1]) ? 0 : 1;
+    outro = 1 - lado;
+    for(ultimo = fim[lado];inicio[lado] < ultimo;inicio[lado]++)
+    {
+      position = fila_6[lado][inicio[lado]][0];
+      speed = fila_6[lado][inicio[lado]][1];
+      solution_6_count++;
+      for(new_speed = speed + 1;new_speed >= speed - 1;new_speed--)
+      {
+        if(lado == 0)
+        { // (position,speed) -> (position + new_speed,new_speed)
+          if(new_speed < 1 || new_speed > _max_road_speed_ || position + new_speed > final_position)
+            continue;
+          for(i = 0;i <= new_speed && new_speed <= max_road_speed[position + i];i++);
+          if(i <= new_speed)
+            continue;
+          p = position + new_speed;
+        }
+        else
+        { // (position - speed,new_speed) -> (position,speed)
+          p = position - speed;
+          if(new_speed < 0 || new_speed > _max_road_speed_ || p < 0 || (p == 0) != (new_speed == 0))
+            continue;
+          for(i = 0;i <= speed && speed <= max_road_speed[p + i];i++);
+          if(i <= speed)
+            continue;
+        }
+        if(dist_6[lado][p][new_speed] >= 0)
+          continue;
+        dist_6[lado][p][new_speed] = profundidade[lado] + 1;
+        ligacao_6[lado][p][new_speed] = speed;
+        fila_6[lado][fim[lado]][0] = p;
+        fila_6[lado][fim[lado]++][1] = new_speed;
+        if(dist_6[outro][p][new_speed] >= 0 && profundidade[lado] + 1 + dist_6[outro][p][new_speed] < best)
+        {
+          best = profundidade[lado] + 1 + dist_6[outro][p][new_speed];
+          meet_position = p;
+          meet_speed = new_speed;
+        }
+      }
+    }
+    profundidade[lado]++;
+  }
+  if(best < _no_path_)
+  {
+    solution_6_best.n_moves = best;
+    // parte da frente (para trás a partir do ponto de encontro)
+    for(position = meet_position,speed = meet_speed,i = dist_6[0][meet_position][meet_speed];i >= 0;i--)
+    {
+      solution_6_best.positions[i] = position;
+      new_speed = ligacao_6[0][position][speed];
+      position -= speed;
+      speed = new_speed;
+    }
+    // parte de trás (para a frente a partir do ponto de encontro)
+    for(position = meet_position,speed = meet_speed,i = dist_6[0][meet_position][meet_speed];i < best;)
+    {
+      speed = ligacao_6[1][position][speed];
+      position += speed;
+      solution_6_best.positions[++i] = position;
+    }
+  }
+  solution_6_elapsed_time = cpu_time() - solution_6_elapsed_time;
+}
+
+
+
+
+
+
 //
 // example of the slides
 //
@@ -551,6 +808,44 @@ int main(int argc,char *argv[argc + 1])
         }
     }
 
+    if(sol == 5) {
+
+        if(solution_5_elapsed_time < _time_limit_)
+        {
+        solve_5(final_position);
+        if(print_this_one != 0)
+        {
+            sprintf(file_name,"%03d_5.pdf",final_position);
+            make_custom_pdf_file(file_name,final_position,&max_road_speed[0],solution_5_best.n_moves,&solution_5_best.positions[0],solution_5_elapsed_time,solution_5_count,"A* search");
+        }
+        printf(" %8d │ %8lu │ %9.3e │",solution_5_best.n_moves,solution_5_count,solution_5_elapsed_time);
+        }
+        else
+        {
+        solution_5_best.n_moves = -1;
+        printf("                                 │");
+        }
+    }
+
+    if(sol == 6) {
+
+        if(solution_6_elapsed_time < _time_limit_)
+        {
+        solve_6(final_position);
+        if(print_this_one != 0)
+        {
+            sprintf(file_name,"%03d_6.pdf",final_position);
+            make_custom_pdf_file(file_name,final_position,&max_road_speed[0],solution_6_best.n_moves,&solution_6_best.positions[0],solution_6_elapsed_time,solution_6_count,"Bidirectional search");
+        }
+        printf(" %8d │ %8lu │ %9.3e │",solution_6_best.n_moves,solution_6_count,solution_6_elapsed_time);
+        }
+        else
+        {
+        solution_6_best.n_moves = -1;
+        printf("                                 │");
+        }
+    }
+
     // done
     printf("\n");
     fflush(stdout);
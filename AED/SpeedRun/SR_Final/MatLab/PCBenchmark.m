@@ -0,0 +1,21 @@
+clear all;
+
+%% Leitura dos resultados de "sol_SpeedRun -s all -r 5 -o benchmark.csv"
+%  (colunas: solver,final_position,n_moves,effort,trials,min,median,mean,stddev)
+T = readtable("benchmark.csv", "TextType", "string", "Delimiter", ",");
+T.solver = string(T.solver);
+solverNames = unique(T.solver, "stable");
+
+%% Plot da mediana do CPU time de cada solver (com o desvio padrão)
+figure(1);
+hold on;
+for i = 1:numel(solverNames)
+    sel = T.solver == solverNames(i);
+    errorbar(T.final_position(sel), T.median(sel), T.stddev(sel), "-+");
+end
+legend(solverNames, "Location", "northwest");
+set(gca, "YScale", "log");
+xlabel("n");
+ylabel("CPU Time (segundos)");
+grid on;
+hold off;
@@ -10,6 +10,23 @@
 //   double t2 = cpu_time();
 //   printf("elapsed time: %.6f seconds\n",t2 - t1);
 //
+// thread_cpu_time() does the same for the calling thread only (use it in multi-threaded programs)
+// wall_time() measures real (wall clock) time
+//
+// profiling of a program fragment (wall time, thread CPU time and, on GNU/Linux, hardware counters):
+//
+//   profile_t p = { 0 };
+//   profile_region(&p)
+//   {
+//     // put your code to be profiled here (do not leave the region with break, goto or return)
+//   }
+//   if(p.valid & (1 << profile_instructions))
+//     printf("%.0f instructions\n",p.counters[profile_instructions]);
+//
+// the measurements of all regions using the same profile_t are added; the hardware counters are read
+// with perf_event_open() and are simply marked as not valid when they are not available (e.g. when
+// /proc/sys/kernel/perf_event_paranoid does not allow it, or inside some virtual machines)
+//
 
 
 #if defined(__linux__) || defined(__APPLE__)
@@ -29,6 +46,24 @@ double cpu_time(void)
   return (double)current_time.tv_sec + 1.0e-9 * (double)current_time.tv_nsec;
 }
 
+double thread_cpu_time(void)
+{ // like cpu_time(), but only counts the time used by the calling thread
+  struct timespec current_time;
+
+  if(clock_gettime(CLOCK_THREAD_CPUTIME_ID,&current_time) != 0)
+    return -1.0; // clock_gettime() failed!!!
+  return (double)current_time.tv_sec + 1.0e-9 * (double)current_time.tv_nsec;
+}
+
+double wall_time(void)
+{
+  struct timespec current_time;
+
+  if(clock_gettime(CLOCK_MONOTONIC,&current_time) != 0)
+    return -1.0; // clock_gettime() failed!!!
+  return (double)current_time.tv_sec + 1.0e-9 * (double)current_time.tv_nsec;
+}
+
 #endif
 
 
@@ -55,4 +90,155 @@ double cpu_time(void)
   return (double)current_time.QuadPart / (double)frequency.QuadPart;
 }
 
+double thread_cpu_time(void)
+{ // not separated by thread on this platform
+  return cpu_time();
+}
+
+double wall_time(void)
+{ // cpu_time() already is a wall clock on this platform
+  return cpu_time();
+}
+
 #endif
+
+
+//
+// hardware performance counters
+//
+
+enum
+{
+  profile_cycles,
+  profile_instructions,
+  profile_branch_misses,
+  profile_l1d_misses,
+  profile_llc_misses,
+  profile_n_counters
+};
+
+#if defined(__linux__)
+
+#include <string.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+
+static __thread int profile_fd[profile_n_counters];
+static __thread int profile_fd_state;  // 0: not yet opened, 1: opened (some may have failed)
+
+static void open_counters(void)
+{ // the counters of the calling thread (user space only, so that they also work with perf_event_paranoid = 2)
+  static const struct { unsigned int type; unsigned long long config; } events[profile_n_counters] =
+  {
+    { PERF_TYPE_HARDWARE,PERF_COUNT_HW_CPU_CYCLES },
+    { PERF_TYPE_HARDWARE,PERF_COUNT_HW_INSTRUCTIONS },
+    { PERF_TYPE_HARDWARE,PERF_COUNT_HW_BRANCH_MISSES },
+    { PERF_TYPE_HW_CACHE,PERF_COUNT_HW_CACHE_L1D | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16) },
+    { PERF_TYPE_HARDWARE,PERF_COUNT_HW_CACHE_MISSES }
+  };
+  struct perf_event_attr attr;
+  int i;
+
+  for(i = 0;i < profile_n_counters;i++)
+  {
+    memset(&attr,0,sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = events[i].type;
+    attr.config = events[i].config;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+    profile_fd[i] = (int)syscall(SYS_perf_event_open,&attr,0,-1,-1,0); // -1 if not available
+  }
+  profile_fd_state = 1;
+}
+
+void close_counters(void)
+{ // call it before a thread that used profile_region() terminates
+  int i;
+
+  if(profile_fd_state != 0)
+    for(i = 0;i < profile_n_counters;i++)
+      if(profile_fd[i] >= 0)
+        close(profile_fd[i]);
+  profile_fd_state = 0;
+}
+
+static int read_counters(double counters[profile_n_counters])
+{ // returns a bit mask of the valid counters (the values are scaled when the counters were multiplexed)
+  unsigned long long data[3];
+  int i,valid;
+
+  if(profile_fd_state == 0)
+    open_counters();
+  valid = 0;
+  for(i = 0;i < profile_n_counters;i++)
+  {
+    counters[i] = 0.0;
+    if(profile_fd[i] >= 0 && read(profile_fd[i],data,sizeof(data)) == (ssize_t)sizeof(data) && data[2] > 0ull)
+    {
+      counters[i] = (double)data[0] * ((double)data[1] / (double)data[2]);
+      valid |= 1 << i;
+    }
+  }
+  return valid;
+}
+
+#else
+
+void close_counters(void)
+{
+}
+
+static int read_counters(double counters[profile_n_counters])
+{ // not available
+  int i;
+
+  for(i = 0;i < profile_n_counters;i++)
+    counters[i] = 0.0;
+  return 0;
+}
+
+#endif
+
+
+//
+// profiling of program regions
+//
+
+typedef struct
+{
+  double wall_time;                       // seconds
+  double thread_cpu_time;                 // seconds
+  double counters[profile_n_counters];    // hardware counters (see the enum above)
+  int valid;                              // bit i is set when counters[i] is valid
+  int n_regions;                          // number of regions measured
+}
+profile_t;
+
+profile_t profile_begin(void)
+{ // the start of a region (the values of the clocks and of the counters)
+  profile_t r;
+
+  r.valid = read_counters(r.counters);
+  r.wall_time = wall_time();
+  r.thread_cpu_time = thread_cpu_time();
+  r.n_regions = 0;
+  return r;
+}
+
+void profile_end(profile_t *r,profile_t *p)
+{ // adds the measurements of the region to p (a counter is only valid if it was valid in all regions)
+  double t_cpu = thread_cpu_time(),t_wall = wall_time(),counters[profile_n_counters];
+  int i,valid;
+
+  valid = read_counters(counters) & r->valid;
+  p->valid = (p->n_regions++ == 0) ? valid : p->valid & valid;
+  p->wall_time += t_wall - r->wall_time;
+  p->thread_cpu_time += t_cpu - r->thread_cpu_time;
+  for(i = 0;i < profile_n_counters;i++)
+    p->counters[i] += counters[i] - r->counters[i];
+}
+
+#define profile_region(p)  for(profile_t _profile_region_ = profile_begin(),*_profile_once_ = &_profile_region_;_profile_once_ != NULL;profile_end(&_profile_region_,(p)),_profile_once_ = NULL)
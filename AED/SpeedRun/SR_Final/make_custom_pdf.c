@@ -9,6 +9,11 @@
 //
 // this file can, and should, be included directly in the main program (speed_run.c)
 //
+// make_custom_pdf_file() is reentrant (all its data lives in the call, except the spiral geometry, computed once, and the statistics,
+// protected by a mutex), so several PDF files can be made at the same time by different threads
+//
+// open_pdf_report(), add_pdf_report_page(), and close_pdf_report() make a single PDF file with many pages (one per solution)
+//
 // some PDF commands:
 //  [width] w                            set line width
 //  [x] [y] m                            move to
@@ -52,8 +57,11 @@
 #include <math.h>
 #include <stdio.h>
 #include <stdarg.h>
+#include <stdint.h>
 #include <stdlib.h>
 #include <string.h>
+#include <time.h>
+#include <pthread.h>
 #if _use_zlib_ > 0
 # include <zlib.h>
 #endif
@@ -85,8 +93,6 @@ typedef struct
 }
 spiral_point_t;
 
-static spiral_point_t spiral_points[1 + _n_spiral_cells_ * _oversampling_];
-
 static double spiral_s(double t)
 { // t -> length
   double t1,t2;
@@ -127,7 +133,7 @@ static void spiral_point_data(double t,double *x,double *y,double *nx,double *ny
   *angle = atan2(dy,dx); // tangent angle
 }
 
-static void create_spiral(void)
+static void create_spiral(spiral_point_t spiral_points[1 + _n_spiral_cells_ * _oversampling_])
 {
   double s0,s1,x,y,nx,ny,angle,l;
   int i,n2;
@@ -179,292 +185,943 @@ static void create_spiral(void)
 }
 
 
+//
+// the spiral geometry and the figure coordinate transformation only depend on the static configuration, so they are computed only once
+//   figure_x = width/2 + figure_scale * (x - figure_x_offset)
+//   figure_y = height/2 + figure_scale * (y - figure_y_offset)
+//
+
+typedef struct
+{
+  spiral_point_t points[1 + _n_spiral_cells_ * _oversampling_];
+  double figure_scale;
+  double figure_x_offset;
+  double figure_y_offset;
+}
+spiral_geometry_t;
+
+static spiral_geometry_t spiral_geometry;
+static pthread_once_t spiral_geometry_once = PTHREAD_ONCE_INIT;
+
+static void init_spiral_geometry(void)
+{
+  double min_x,max_x,min_y,max_y,s0,s1;
+  spiral_point_t *spiral_points;
+  int i,n;
+
+  spiral_points = spiral_geometry.points;
+  create_spiral(spiral_points);
+  n = _oversampling_ * _n_spiral_cells_;
+  min_x = max_x = min_y = max_y = 0.0;
+  for(i = 0;i <= n;i++)
+  {
+#define update_bounding_box(x,y) do              \
+                                 {               \
+                                   if(x < min_x) \
+                                     min_x = x;  \
+                                   if(x > max_x) \
+                                     max_x = x;  \
+                                   if(y < min_y) \
+                                     min_y = y;  \
+                                   if(y > max_y) \
+                                     max_y = y;  \
+                                 }               \
+                                 while(0)
+    update_bounding_box(spiral_points[i].x,spiral_points[i].y);
+    update_bounding_box(spiral_points[i].x_in,spiral_points[i].y_in);
+    update_bounding_box(spiral_points[i].x_out,spiral_points[i].y_out);
+#undef update_bounding_box
+  }
+  s0 = (double)_figure_width_ / (max_x - min_x);
+  s1 = (double)_figure_height_ / (max_y - min_y);
+  spiral_geometry.figure_scale = 0.99 * ((s0 < s1) ? s0 : s1);
+  spiral_geometry.figure_x_offset = 0.5 * (max_x + min_x);
+  spiral_geometry.figure_y_offset = 0.5 * (max_y + min_y);
+}
+
+
 //
 // private PDF stuff
 //
+// the PDF file is written as it is made, through a large output buffer; each content stream is made in a small buffer
+// that, when full, is compressed (or copied) to the output buffer, so the memory used does not depend on the size of
+// the figure; as the length of a stream is only known at its end, it is written in another object (/Length n 0 R)
+//
+// when set_pdf_compression() asks for more than one thread, the three content streams of a page are made (and compressed)
+// at the same time by different threads; each one then goes to a memory writer (fp == NULL), whose contents are copied to
+// the file when all are done
+//
 
-#define max_pdf_objects 10
+#define _pdf_buffer_size_  65536  // the size of the output buffer
+#define _pdf_chunk_size_   16384  // the size of the buffer of a content stream (must be much larger than 256)
 
-typedef enum { is_pdf_object,is_pdf_stream } pdf_object_type_t;
+typedef struct
+{
+  FILE *fp;
+  long file_offset;                        // the number of bytes of the file so far (including the ones still in the output buffer)
+  int buffer_size;                         // the number of bytes in the output buffer
+  unsigned char buffer[_pdf_buffer_size_]; // the output buffer
+  char chunk[_pdf_chunk_size_];            // the buffer of the content stream being made
+  long stream_start;                       // the file offset of the data of the content stream being made
+  int stream_length_object;                // the object number of its length
+  int n_pdf_objects;                       // the largest object number so far
+  int max_pdf_objects;                     // the size of the file_offsets array
+  long *file_offsets;                      // file_offsets[i] is the file offset of object #(1 + i)
+  char *memory;                            // the data of a memory writer
+  long memory_max_size;                    // the size of the memory array
+  long contents_size;                      // the number of bytes given to write_pdf_stream_data() (before compression)
+  double compression_time;                 // the thread CPU time spent in write_pdf_stream_data()
+#if _use_zlib_ > 0
+  int z_initialized;                       // the compressor is initialized once and reset for each stream
+  z_stream z;
+#endif
+}
+pdf_writer_t;
 
 typedef struct
 {
-  int file_offset;        // the byte number where the start of the object is located in the PDF file (computed)
-  int contents_size;      // the number of bytes of the content (computed, only used for contents that grow on demand)
-  int contents_max_size;  // the maximum number of bytes of the content (computed, only used for contents that grow on demand)
-  pdf_object_type_t type; // the type of the PDF object (given)
-  char *contents;         // the contents of the object (given)
+  int contents_size;      // the number of bytes in the buffer
+  int contents_max_size;  // the size of the buffer
+  char *contents;         // the part of the stream not yet compressed (or copied) to the output buffer
+  pdf_writer_t *writer;   // where it goes
+}
+pdf_stream_t;
+
+//
+// compression settings and statistics
+//
+
+static int pdf_compression_level = 9;    // 0 (no compression) to 9 (best compression)
+static int pdf_compression_strategy = 0; // index into pdf_compression_strategy_names[]
+static int pdf_compression_threads = 1;  // the number of threads that make the three content streams of a page (1: straight to the file)
+static const char *pdf_compression_strategy_names[] = { "default","filtered","huffman","rle","fixed" };
+#if _use_zlib_ > 0
+static const int pdf_compression_strategy_values[] = { Z_DEFAULT_STRATEGY,Z_FILTERED,Z_HUFFMAN_ONLY,Z_RLE,Z_FIXED };
+#endif
+
+static struct
+{
+  int n_pages;             // the number of pages made so far
+  double formatting_time;  // the thread CPU time spent making the contents of the streams
+  double compression_time; // the thread CPU time spent compressing (or copying) them
+  double page_time;        // the wall time spent making the streams of the pages
+  long contents_size;      // their size before compression
+  long streams_size;       // their size after compression
+}
+pdf_statistics;
+static pthread_mutex_t pdf_statistics_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static double pdf_time(clockid_t clock_id)
+{
+  struct timespec t;
+
+  clock_gettime(clock_id,&t);
+  return (double)t.tv_sec + 1.0e-9 * (double)t.tv_nsec;
+}
+
+static void flush_pdf_writer(pdf_writer_t *writer)
+{
+  if(writer->fp == NULL)
+  { // memory writer
+    if(writer->file_offset > writer->memory_max_size)
+    {
+      writer->memory_max_size = writer->file_offset + writer->memory_max_size / 2;
+      writer->memory = (char *)realloc(writer->memory,(size_t)writer->memory_max_size);
+      if(writer->memory == NULL)
+      {
+        fprintf(stderr,"flush_pdf_writer: out of memory\n");
+        exit(1);
+      }
+    }
+    memcpy(&writer->memory[writer->file_offset - writer->buffer_size],writer->buffer,(size_t)writer->buffer_size);
+    writer->buffer_size = 0;
+    return;
+  }
+  if(writer->buffer_size > 0 && fwrite((void *)writer->buffer,sizeof(unsigned char),(size_t)writer->buffer_size,writer->fp) != (size_t)writer->buffer_size)
+  {
+    fprintf(stderr,"flush_pdf_writer: write error\n");
+    exit(1);
+  }
+  writer->buffer_size = 0;
 }
-pdf_object_t;
 
-static pdf_object_t pdf_objects[max_pdf_objects];
-static int n_pdf_objects;
+static void write_pdf_bytes(pdf_writer_t *writer,const char *data,int n_bytes)
+{
+  int n;
+
+  while(n_bytes > 0)
+  {
+    if(writer->buffer_size == _pdf_buffer_size_)
+      flush_pdf_writer(writer);
+    n = _pdf_buffer_size_ - writer->buffer_size;
+    if(n > n_bytes)
+      n = n_bytes;
+    memcpy(&writer->buffer[writer->buffer_size],data,(size_t)n);
+    writer->buffer_size += n;
+    writer->file_offset += n;
+    data += n;
+    n_bytes -= n;
+  }
+}
 
 #ifdef __GNUC__
 __attribute__((__format__(printf,2,3)))
 #endif
-static void add_pdf_content(pdf_object_t *pdf_object,const char *format,...)
-{
-  int size_increment;
+static void write_pdf_text(pdf_writer_t *writer,const char *format,...)
+{ // for short texts (at most 255 bytes)
+  int n;
   va_list ap;
 
-  if(pdf_object->contents_size + 256 > pdf_object->contents_max_size)
+  if(writer->buffer_size + 256 > _pdf_buffer_size_)
+    flush_pdf_writer(writer);
+  va_start(ap,format);
+  n = vsnprintf((char *)&writer->buffer[writer->buffer_size],256,format,ap);
+  va_end(ap);
+  if(n >= 256)
   {
-    pdf_object->contents_max_size = 256 + pdf_object->contents_max_size + pdf_object->contents_max_size / 2;
-    pdf_object->contents = (char *)realloc(pdf_object->contents,(size_t)pdf_object->contents_max_size);
-    if(pdf_object->contents == NULL)
+    fprintf(stderr,"write_pdf_text: internal error (too much data added in one go)\n");
+    exit(1);
+  }
+  writer->buffer_size += n;
+  writer->file_offset += n;
+}
+
+static void begin_pdf_object(pdf_writer_t *writer,int object_number)
+{
+  if(object_number > writer->max_pdf_objects)
+  {
+    writer->max_pdf_objects = 2 * object_number + 64;
+    writer->file_offsets = (long *)realloc(writer->file_offsets,(size_t)writer->max_pdf_objects * sizeof(long));
+    if(writer->file_offsets == NULL)
+    {
+      fprintf(stderr,"begin_pdf_object: out of memory\n");
+      exit(1);
+    }
+  }
+  writer->file_offsets[object_number - 1] = writer->file_offset;
+  if(object_number > writer->n_pdf_objects)
+    writer->n_pdf_objects = object_number;
+  write_pdf_text(writer,"%d 0 obj\n",object_number);
+}
+
+static void end_pdf_object(pdf_writer_t *writer)
+{
+  write_pdf_text(writer,"endobj\n");
+}
+
+static void write_pdf_stream_data(pdf_writer_t *writer,const char *data,int n_bytes,int finish)
+{
+  double t;
+
+  t = pdf_time(CLOCK_THREAD_CPUTIME_ID);
+  writer->contents_size += n_bytes;
+#if _use_zlib_ > 0
+  // documentation on how to use the zlib compression library in /usr/include/zlib.h
+  int status,n;
+
+  writer->z.next_in = (unsigned char *)data;
+  writer->z.avail_in = (unsigned int)n_bytes;
+  do
+  { // the compressed data goes directly to the output buffer
+    if(writer->buffer_size == _pdf_buffer_size_)
+      flush_pdf_writer(writer);
+    n = _pdf_buffer_size_ - writer->buffer_size;
+    writer->z.next_out = &writer->buffer[writer->buffer_size];
+    writer->z.avail_out = (unsigned int)n;
+    status = deflate(&writer->z,(finish != 0) ? Z_FINISH : Z_NO_FLUSH);
+    if(status == Z_STREAM_ERROR)
+    {
+      fprintf(stderr,"write_pdf_stream_data: deflate() failed\n");
+      exit(1);
+    }
+    n -= (int)writer->z.avail_out;
+    writer->buffer_size += n;
+    writer->file_offset += n;
+  }
+  while(writer->z.avail_out == 0 || (finish != 0 && status != Z_STREAM_END));
+#else
+  (void)finish;
+  write_pdf_bytes(writer,data,n_bytes);
+#endif
+  writer->compression_time += pdf_time(CLOCK_THREAD_CPUTIME_ID) - t;
+}
+
+static void write_pdf_stream_header(pdf_writer_t *writer,int object_number,int length_object_number)
+{
+  begin_pdf_object(writer,object_number);
+#if _use_zlib_ > 0
+  write_pdf_text(writer,"<< /Length %d 0 R /Filter /FlateDecode >> stream\n",length_object_number);
+#else
+  write_pdf_text(writer,"<< /Length %d 0 R >> stream\n",length_object_number);
+#endif
+}
+
+static void write_pdf_stream_trailer(pdf_writer_t *writer,long length,int length_object_number)
+{
+  write_pdf_text(writer,"\nendstream\n");
+  end_pdf_object(writer);
+  // the length of the stream
+  begin_pdf_object(writer,length_object_number);
+  write_pdf_text(writer,"%ld\n",length);
+  end_pdf_object(writer);
+}
+
+static void begin_pdf_stream(pdf_writer_t *writer,pdf_stream_t *pdf_stream)
+{ // the stream data (the header must have been written before, if needed)
+#if _use_zlib_ > 0
+  if(writer->z_initialized == 0)
+  {
+    writer->z.zalloc = Z_NULL;
+    writer->z.zfree = Z_NULL;
+    writer->z.opaque = Z_NULL;
+    if(deflateInit2(&writer->z,pdf_compression_level,Z_DEFLATED,15,8,pdf_compression_strategy_values[pdf_compression_strategy]) != Z_OK)
     {
-      fprintf(stderr,"add_pdf_content: out of memory\n");
+      fprintf(stderr,"begin_pdf_stream: deflateInit2() failed\n");
       exit(1);
     }
+    writer->z_initialized = 1;
+  }
+  else if(deflateReset(&writer->z) != Z_OK)
+  {
+    fprintf(stderr,"begin_pdf_stream: deflateReset() failed\n");
+    exit(1);
   }
+#endif
+  writer->stream_start = writer->file_offset;
+  pdf_stream->contents_size = 0;
+  pdf_stream->contents_max_size = _pdf_chunk_size_;
+  pdf_stream->contents = writer->chunk;
+  pdf_stream->writer = writer;
+}
+
+static void flush_pdf_stream(pdf_stream_t *pdf_stream)
+{
+  write_pdf_stream_data(pdf_stream->writer,pdf_stream->contents,pdf_stream->contents_size,0);
+  pdf_stream->contents_size = 0;
+}
+
+static long end_pdf_stream(pdf_stream_t *pdf_stream)
+{ // returns the length of the stream data
+  pdf_writer_t *writer = pdf_stream->writer;
+
+  // remove \n at the end of the contents (because one will be added automatically by write_pdf_stream_trailer())
+  while(pdf_stream->contents_size > 0 && pdf_stream->contents[pdf_stream->contents_size - 1] == '\n')
+    pdf_stream->contents_size--;
+  write_pdf_stream_data(writer,pdf_stream->contents,pdf_stream->contents_size,1);
+  pdf_stream->contents = NULL;
+  pdf_stream->writer = NULL;
+  return writer->file_offset - writer->stream_start;
+}
+
+static pdf_writer_t *new_pdf_writer(void)
+{ // a memory writer
+  pdf_writer_t *writer;
+
+  writer = (pdf_writer_t *)calloc(1,sizeof(pdf_writer_t));
+  if(writer == NULL)
+  {
+    fprintf(stderr,"new_pdf_writer: out of memory\n");
+    exit(1);
+  }
+  return writer;
+}
+
+static void free_pdf_writer(pdf_writer_t *writer)
+{
+#if _use_zlib_ > 0
+  if(writer->z_initialized != 0)
+    (void)deflateEnd(&writer->z);
+#endif
+  free(writer->file_offsets);
+  free(writer->memory);
+  free(writer);
+}
+
+static pdf_writer_t *open_pdf_writer(const char *pdf_file_name,const char *caller)
+{
+  pdf_writer_t *writer;
+
+  writer = new_pdf_writer();
+  writer->fp = fopen(pdf_file_name,"wb");
+  if(writer->fp == NULL)
+  {
+    fprintf(stderr,"%s: unable to create file %s\n",caller,pdf_file_name);
+    exit(1);
+  }
+  setvbuf(writer->fp,NULL,_IONBF,0); // the writer has its own buffer
+  write_pdf_text(writer,"%%PDF-1.4\n");
+  write_pdf_text(writer,"%%\xC3\xA1\xC3\xA1\n");
+  return writer;
+}
+
+static void close_pdf_writer(pdf_writer_t *writer)
+{ // write the cross-reference table and the trailer, and clean up
+  long xref_offset;
+  int i;
+
+  xref_offset = writer->file_offset;
+  write_pdf_text(writer,"xref\n");
+  write_pdf_text(writer,"0 %d\n",writer->n_pdf_objects + 1);
+  write_pdf_text(writer,"0000000000 65535 f \n"); // note the space before the new line!
+  for(i = 0;i < writer->n_pdf_objects;i++)
+    write_pdf_text(writer,"%010ld 00000 n \n",writer->file_offsets[i]);
+  write_pdf_text(writer,"trailer << /Size %d /Root 1 0 R /ID [<AED02022> <AED02022>]>>\n",1 + writer->n_pdf_objects);
+  write_pdf_text(writer,"startxref\n");
+  write_pdf_text(writer,"%ld\n",xref_offset);
+  write_pdf_text(writer,"%%%%EOF\n");
+  flush_pdf_writer(writer);
+  if(fclose(writer->fp) != 0)
+  {
+    fprintf(stderr,"close_pdf_writer: write error\n");
+    exit(1);
+  }
+  free_pdf_writer(writer);
+}
+
+#ifdef __GNUC__
+__attribute__((__format__(printf,2,3)))
+#endif
+static void add_pdf_content(pdf_stream_t *pdf_stream,const char *format,...)
+{
+  int size_increment;
+  va_list ap;
+
+  if(pdf_stream->contents_size + 256 > pdf_stream->contents_max_size)
+    flush_pdf_stream(pdf_stream);
   va_start(ap,format);
-  size_increment = vsnprintf(&pdf_object->contents[pdf_object->contents_size],(size_t)(pdf_object->contents_max_size - pdf_object->contents_size),format,ap);
+  size_increment = vsnprintf(&pdf_stream->contents[pdf_stream->contents_size],(size_t)(pdf_stream->contents_max_size - pdf_stream->contents_size),format,ap);
   va_end(ap);
-  if(size_increment >= pdf_object->contents_max_size - pdf_object->contents_size)
+  if(size_increment >= pdf_stream->contents_max_size - pdf_stream->contents_size)
   {
     fprintf(stderr,"add_pdf_content: internal error (too much data added in one go)\n");
     exit(1);
   }
-  pdf_object->contents_size += size_increment;
+  pdf_stream->contents_size += size_increment;
 }
 
-
 //
-// the public PDF stuff
+// fast path for the bulk of the contents (the coordinates): the space is reserved once for a batch of
+// appends, which then write directly into the buffer; the output is exactly the same as with "%.3f"
 //
 
-void make_custom_pdf_file(char *pdf_file_name,int road_size,int max_road_speed[1 + road_size],int n_moves,int positions[1 + n_moves],double elapsed_time,unsigned long effort,char *title)
-{
-  double figure_x_offset,figure_y_offset,figure_scale,min_x,max_x,min_y,max_y,s0,s1;
-  int i,j,k,n,file_offset;
-  char info[64];
-  FILE *fp;
+static char *reserve_pdf_content(pdf_stream_t *pdf_stream,int n_bytes)
+{ // returns where to write (at most n_bytes); the caller must update contents_size
+  if(pdf_stream->contents_size + n_bytes + 1 > pdf_stream->contents_max_size)
+  {
+    flush_pdf_stream(pdf_stream);
+    if(n_bytes + 1 > pdf_stream->contents_max_size)
+    {
+      fprintf(stderr,"reserve_pdf_content: internal error (too much data added in one go)\n");
+      exit(1);
+    }
+  }
+  return &pdf_stream->contents[pdf_stream->contents_size];
+}
 
-  if(1 + road_size > _n_spiral_cells_)
+static char *put_fixed_3(char *p,double x)
+{ // same as sprintf(p,"%.3f",x), but much faster (at most 16 bytes)
+  double y,f;
+  long long r;
+  char digits[16];
+  int n,frac;
+
+  if(signbit(x))
   {
-    fprintf(stderr,"make_custom_pdf_file: road_size is too large\n");
-    exit(1);
+    *p++ = '-';
+    x = -x;
   }
-  fp = fopen(pdf_file_name,"wb");
-  if(fp == NULL)
+  y = 1000.0 * x;
+  f = floor(y);
+  if(!(y < 1.0e9) || fabs(y - f - 0.5) < 1.0e-6)
+    return p + sprintf(p,"%.3f",x); // too large, too close to a rounding tie, or not a number
+  r = (long long)f + ((y - f > 0.5) ? 1 : 0);
+  frac = (int)(r % 1000);
+  r /= 1000;
+  n = 0;
+  do
   {
-    fprintf(stderr,"make_custom_pdf_file: unable to create file %s\n",pdf_file_name);
-    exit(1);
+    digits[n++] = (char)('0' + (int)(r % 10));
+    r /= 10;
   }
-  //
-  // create spiral and compute coordinate transformation data
-  //   figure_x = width/2 + figure_scale * (x - figure_x_offset)
-  //   figure_y = height/2 + figure_scale * (y - figure_y_offset)
-  //
+  while(r > 0);
+  while(n > 0)
+    *p++ = digits[--n];
+  *p++ = '.';
+  *p++ = (char)('0' + frac / 100);
+  *p++ = (char)('0' + frac / 10 % 10);
+  *p++ = (char)('0' + frac % 10);
+  return p;
+}
+
 # define figure_x(x)  (0.5 * (double)_figure_width_ + figure_scale * ((x) - figure_x_offset))
 # define figure_y(y)  (0.5 * (double)_figure_height_ + figure_scale * ((y) - figure_y_offset))
-  create_spiral();
-  n = _oversampling_ * _n_spiral_cells_;
-  min_x = max_x = min_y = max_y = 0.0;
-  for(i = 0;i <= n;i++)
+#define put_bytes(p,string)  (memcpy((p),(string),sizeof(string) - 1),(p) + sizeof(string) - 1)
+
+static void add_pdf_cell(pdf_stream_t *pdf_stream,const spiral_point_t *cell,const char *end)
+{ // the outline of a spiral cell: "x y m x y l ... x y l" followed by end (the same as the "%.3f %.3f m" and " %.3f %.3f l" formats)
+  const double figure_scale = spiral_geometry.figure_scale,figure_x_offset = spiral_geometry.figure_x_offset,figure_y_offset = spiral_geometry.figure_y_offset;
+  char *p;
+  int j;
+
+  p = reserve_pdf_content(pdf_stream,(2 * _oversampling_ + 2) * 36 + 16);
+  p = put_fixed_3(p,figure_x(cell[0].x_in));
+  *p++ = ' ';
+  p = put_fixed_3(p,figure_y(cell[0].y_in));
+  p = put_bytes(p," m");
+  for(j = 1;j <= _oversampling_;j++)
   {
-#define update_bounding_box(x,y) do              \
-                                 {               \
-                                   if(x < min_x) \
-                                     min_x = x;  \
-                                   if(x > max_x) \
-                                     max_x = x;  \
-                                   if(y < min_y) \
-                                     min_y = y;  \
-                                   if(y > max_y) \
-                                     max_y = y;  \
-                                 }               \
-                                 while(0)
-    update_bounding_box(spiral_points[i].x,spiral_points[i].y);
-    update_bounding_box(spiral_points[i].x_in,spiral_points[i].y_in);
-    update_bounding_box(spiral_points[i].x_out,spiral_points[i].y_out);
-#undef update_bounding_box
+    *p++ = ' ';
+    p = put_fixed_3(p,figure_x(cell[j].x_in));
+    *p++ = ' ';
+    p = put_fixed_3(p,figure_y(cell[j].y_in));
+    p = put_bytes(p," l");
   }
-  s0 = (double)_figure_width_ / (max_x - min_x);
-  s1 = (double)_figure_height_ / (max_y - min_y);
-  figure_scale = 0.99 * ((s0 < s1) ? s0 : s1);
-  figure_x_offset = 0.5 * (max_x + min_x);
-  figure_y_offset = 0.5 * (max_y + min_y);
-  //
-  // create the PDF objects
-  //
-  // the catalog (object #1)
-  pdf_objects[0].type = is_pdf_object;
-  pdf_objects[0].contents_size = 0;
-  pdf_objects[0].contents_max_size = 0;
-  pdf_objects[0].contents = "<< /Type /Catalog /Pages 2 0 R >>";
-  // the list of pages (object #2)
-  pdf_objects[1].type = is_pdf_object;
-  pdf_objects[1].contents_size = 0;
-  pdf_objects[1].contents_max_size = 0;
-  pdf_objects[1].contents = "<< /Type /Pages /Kids [3 0 R] /Count 1 >>";
-  // the description of the page (object #3)
-  pdf_objects[2].type = is_pdf_object;
-  pdf_objects[2].contents_size = 0;
-  pdf_objects[2].contents_max_size = 0;
-  pdf_objects[2].contents = NULL;
-  add_pdf_content(&pdf_objects[2],"<< /Type /Page /Parent 2 0 R /MediaBox [0 0 %d %d] /Contents [5 0 R 6 0 R 7 0 R] /Resources << /Font << /MyFont 4 0 R >> /ProcSet [/PDF /Text] >> >>",_figure_width_,_figure_height_);
-  // the font used by the page (object #4)
-  pdf_objects[3].type = is_pdf_object;
-  pdf_objects[3].contents_size = 0;
-  pdf_objects[3].contents_max_size = 0;
-  pdf_objects[3].contents = "<< /Type /Font /Subtype /Type1 /Name /MyFont /BaseFont /Courier-Bold /Encoding /StandardEncoding >>";
-  // the spiral cell highlights (object #5)
-  pdf_objects[4].type = is_pdf_stream;
-  pdf_objects[4].contents_size = 0;
-  pdf_objects[4].contents_max_size = 0;
-  pdf_objects[4].contents = NULL;
-  // the spiral cell borders (object #6)
-  pdf_objects[5].type = is_pdf_stream;
-  pdf_objects[5].contents_size = 0;
-  pdf_objects[5].contents_max_size = 0;
-  pdf_objects[5].contents = NULL;
-  // the speed data (object #7)
-  pdf_objects[6].type = is_pdf_stream;
-  pdf_objects[6].contents_size = 0;
-  pdf_objects[6].contents_max_size = 0;
-  pdf_objects[6].contents = NULL;
-  // no more objects
-  n_pdf_objects = 7;
-  // add the highlight cells to object #5
-  add_pdf_content(&pdf_objects[4],"0.8 0.8 0.8 rg\n"); // fill color is gray
-  for(k = 0;k <= n_moves;k++)
+  for(j = _oversampling_;j >= 0;j--)
   {
-    i = _oversampling_ * positions[k];
-    add_pdf_content(&pdf_objects[4],"%.3f %.3f m",figure_x(spiral_points[i].x_in),figure_y(spiral_points[i].y_in));
-    for(j = 1;j <= _oversampling_;j++)
-      add_pdf_content(&pdf_objects[4]," %.3f %.3f l",figure_x(spiral_points[i + j].x_in),figure_y(spiral_points[i + j].y_in));
-    for(j = _oversampling_;j >= 0;j--)
-      add_pdf_content(&pdf_objects[4]," %.3f %.3f l",figure_x(spiral_points[i + j].x_out),figure_y(spiral_points[i + j].y_out));
-    add_pdf_content(&pdf_objects[4]," h f\n");
-  }
-  // add the spiral cell borders to object #6
-  add_pdf_content(&pdf_objects[5],"0 0 0 RG 0.4 w\n"); // stroke color is black, linewidth is 0.4pt
-  add_pdf_content(&pdf_objects[5],"%.3f %.3f m %.3f %.3f l S\n",figure_x(spiral_points[0].x_in),figure_y(spiral_points[0].y_in),figure_x(spiral_points[0].x_out),figure_y(spiral_points[0].y_out));
+    *p++ = ' ';
+    p = put_fixed_3(p,figure_x(cell[j].x_out));
+    *p++ = ' ';
+    p = put_fixed_3(p,figure_y(cell[j].y_out));
+    p = put_bytes(p," l");
+  }
+  while(*end != '\0')
+    *p++ = *end++;
+  *p = '\0';
+  pdf_stream->contents_size = (int)(p - pdf_stream->contents);
+}
+
+
+//
+// the three content streams of a page (objects #first_object, #first_object + 1, and #first_object + 2, with their
+// lengths in the next three objects): the highlighted cells, the cell borders, and the text
+//   all_borders != 0: the borders of all cells (black up to road_size, then gray)
+//   all_borders == 0: only the (black) borders of the cells up to road_size; the gray ones are shared by the pages of a report
+//
+// level of detail: when the road does not fit in the spiral, each spiral cell shows a band of g = 1 + road_size / _n_spiral_cells_
+// consecutive road cells; a band is highlighted when the solution stops in one of its cells, and its number is the smallest
+// maximum speed of its cells (the speed that limits the moves through it), so the size of the figure does not depend on road_size
+//
+
+typedef struct
+{
+  int road_size;
+  uint8_t *max_road_speed;
+  int n_moves;
+  int *positions;
+  double elapsed_time;
+  unsigned long effort;
+  char *title;
+  int all_borders;
+  int g;         // the number of road cells per spiral cell
+  int last_band; // the spiral cell of the last road cell
+}
+pdf_page_t;
+
+static void make_pdf_highlights(pdf_stream_t *pdf_stream,const pdf_page_t *page)
+{
+  const spiral_point_t *spiral_points = spiral_geometry.points;
+  int k,band;
+
+  add_pdf_content(pdf_stream,"0.8 0.8 0.8 rg\n"); // fill color is gray
+  for(k = 0,band = -1;k <= page->n_moves;k++)
+    if(page->positions[k] / page->g != band)
+    { // the positions increase, so each band is drawn only once
+      band = page->positions[k] / page->g;
+      add_pdf_cell(pdf_stream,&spiral_points[_oversampling_ * band]," h f\n");
+    }
+}
+
+static void make_pdf_borders(pdf_stream_t *pdf_stream,const pdf_page_t *page)
+{
+  const double figure_scale = spiral_geometry.figure_scale,figure_x_offset = spiral_geometry.figure_x_offset,figure_y_offset = spiral_geometry.figure_y_offset;
+  const spiral_point_t *spiral_points = spiral_geometry.points;
+  int i,n;
+
+  n = (page->all_borders != 0) ? _oversampling_ * _n_spiral_cells_ : _oversampling_ * (1 + page->last_band);
+  add_pdf_content(pdf_stream,"0 0 0 RG 0.4 w\n"); // stroke color is black, linewidth is 0.4pt
+  add_pdf_content(pdf_stream,"%.3f %.3f m %.3f %.3f l S\n",figure_x(spiral_points[0].x_in),figure_y(spiral_points[0].y_in),figure_x(spiral_points[0].x_out),figure_y(spiral_points[0].y_out));
   for(i = 0;i < n;i += _oversampling_)
   {
-    if(i == _oversampling_ * (1 + positions[n_moves]))
-      add_pdf_content(&pdf_objects[5],"0.8 0.8 0.8 RG\n"); // switch to gray
-    add_pdf_content(&pdf_objects[5],"%.3f %.3f m",figure_x(spiral_points[i].x_in),figure_y(spiral_points[i].y_in));
-    for(j = 1;j <= _oversampling_;j++)
-      add_pdf_content(&pdf_objects[5]," %.3f %.3f l",figure_x(spiral_points[i + j].x_in),figure_y(spiral_points[i + j].y_in));
-    for(j = _oversampling_;j >= 0;j--)
-      add_pdf_content(&pdf_objects[5]," %.3f %.3f l",figure_x(spiral_points[i + j].x_out),figure_y(spiral_points[i + j].y_out));
-    add_pdf_content(&pdf_objects[5]," S\n");
-  }
-  // add the cell numbers to object #7
-  s0 = 0.8 * figure_scale * (spiral_points[n / 2].s - spiral_points[0].s) / (double)(_n_spiral_cells_ / 2); // the font size (the spiral length data is only good in the first half...)
-  add_pdf_content(&pdf_objects[6],"BT 0 0 0 rg /MyFont %.3f Tf\n",s0); // fill color is black, set the font
-  sprintf(info,"%d move%s",n_moves,(n_moves == 1) ? "" : "s");
-  add_pdf_content(&pdf_objects[6],"1 0 0 1 %.3f %.3f Tm (%s) Tj\n",0.5 * _figure_width_ - 0.3 * (double)strlen(info) * s0,2.2 * s0,info);
-  sprintf(info,"%.3e seconds",elapsed_time);
-  add_pdf_content(&pdf_objects[6],"1 0 0 1 %.3f %.3f Tm (%s) Tj\n",0.5 * _figure_width_ - 0.3 * (double)strlen(info) * s0,1.2 * s0,info);
-  sprintf(info,"effort: %lu",effort);
-  add_pdf_content(&pdf_objects[6],"1 0 0 1 %.3f %.3f Tm (%s) Tj\n",0.5 * _figure_width_ - 0.3 * (double)strlen(info) * s0,0.2 * s0,info);
-  add_pdf_content(&pdf_objects[6],"1 0 0 1 %.3f %.3f Tm (%s) Tj\n",0.5 * _figure_width_ - 0.3 * (double)strlen(title) * s0,(double)_figure_height_ - s0,title);
-  sprintf(info,"road size: %d",road_size);
-  add_pdf_content(&pdf_objects[6],"1 0 0 1 %.3f %.3f Tm (%s) Tj\n",0.5 * _figure_width_ - 0.3 * (double)strlen(info) * s0,(double)_figure_height_ - 2.0 * s0,info);
-  for(i = 0;i <= road_size;i++)
+    if(i == _oversampling_ * (1 + page->positions[page->n_moves] / page->g))
+      add_pdf_content(pdf_stream,"0.8 0.8 0.8 RG\n"); // switch to gray
+    add_pdf_cell(pdf_stream,&spiral_points[i]," S\n");
+  }
+}
+
+static void make_pdf_text(pdf_stream_t *pdf_stream,const pdf_page_t *page)
+{
+  const double figure_scale = spiral_geometry.figure_scale,figure_x_offset = spiral_geometry.figure_x_offset,figure_y_offset = spiral_geometry.figure_y_offset;
+  const spiral_point_t *spiral_points = spiral_geometry.points;
+  const int g = page->g;
+  int i,j,band,min_speed;
+  double s0;
+  char info[64];
+  char *p;
+
+  s0 = 0.8 * figure_scale * (spiral_points[_oversampling_ * _n_spiral_cells_ / 2].s - spiral_points[0].s) / (double)(_n_spiral_cells_ / 2); // the font size (the spiral length data is only good in the first half...)
+  add_pdf_content(pdf_stream,"BT 0 0 0 rg /MyFont %.3f Tf\n",s0); // fill color is black, set the font
+  sprintf(info,"%d move%s",page->n_moves,(page->n_moves == 1) ? "" : "s");
+  add_pdf_content(pdf_stream,"1 0 0 1 %.3f %.3f Tm (%s) Tj\n",0.5 * _figure_width_ - 0.3 * (double)strlen(info) * s0,2.2 * s0,info);
+  sprintf(info,"%.3e seconds",page->elapsed_time);
+  add_pdf_content(pdf_stream,"1 0 0 1 %.3f %.3f Tm (%s) Tj\n",0.5 * _figure_width_ - 0.3 * (double)strlen(info) * s0,1.2 * s0,info);
+  sprintf(info,"effort: %lu",page->effort);
+  add_pdf_content(pdf_stream,"1 0 0 1 %.3f %.3f Tm (%s) Tj\n",0.5 * _figure_width_ - 0.3 * (double)strlen(info) * s0,0.2 * s0,info);
+  add_pdf_content(pdf_stream,"1 0 0 1 %.3f %.3f Tm (%s) Tj\n",0.5 * _figure_width_ - 0.3 * (double)strlen(page->title) * s0,(double)_figure_height_ - s0,page->title);
+  if(g == 1)
+    sprintf(info,"road size: %d",page->road_size);
+  else
+    sprintf(info,"road size: %d (%d per cell)",page->road_size,g);
+  add_pdf_content(pdf_stream,"1 0 0 1 %.3f %.3f Tm (%s) Tj\n",0.5 * _figure_width_ - 0.3 * (double)strlen(info) * s0,(double)_figure_height_ - 2.0 * s0,info);
+  for(band = 0;band <= page->last_band;band++)
+  {
+    min_speed = page->max_road_speed[band * g];
+    for(i = band * g + 1;i < (band + 1) * g && i <= page->road_size;i++)
+      if(page->max_road_speed[i] < min_speed)
+        min_speed = page->max_road_speed[i];
+    j = band * _oversampling_ + _oversampling_ / 2; // the index corresponding to the center of the cell
+    p = reserve_pdf_content(pdf_stream,64);
+    p = put_bytes(p,"1 0 0 1 ");
+    p = put_fixed_3(p,figure_x(spiral_points[j].x) - 0.3 * s0);
+    *p++ = ' ';
+    p = put_fixed_3(p,figure_y(spiral_points[j].y) - 0.35 * s0);
+    p += sprintf(p," Tm (%d) Tj\n",min_speed);
+    pdf_stream->contents_size = (int)(p - pdf_stream->contents);
+  }
+  add_pdf_content(pdf_stream,"ET");
+}
+
+static void (*const pdf_page_stream_makers[3])(pdf_stream_t *,const pdf_page_t *) = { make_pdf_highlights,make_pdf_borders,make_pdf_text };
+
+typedef struct
+{
+  const pdf_page_t *page;
+  int stream;              // 0 (the highlighted cells), 1 (the cell borders), or 2 (the text)
+  pdf_writer_t *writer;    // where the stream data goes
+  long length;             // the length of the stream data
+  double formatting_time;  // thread CPU time
+  double compression_time; // thread CPU time
+  long contents_size;      // before compression
+}
+pdf_stream_job_t;
+
+static void make_pdf_stream(pdf_stream_job_t *job)
+{
+  pdf_stream_t pdf_stream;
+  double t,c;
+  long n;
+
+  t = pdf_time(CLOCK_THREAD_CPUTIME_ID);
+  c = job->writer->compression_time;
+  n = job->writer->contents_size;
+  begin_pdf_stream(job->writer,&pdf_stream);
+  (*pdf_page_stream_makers[job->stream])(&pdf_stream,job->page);
+  job->length = end_pdf_stream(&pdf_stream);
+  job->compression_time = job->writer->compression_time - c;
+  job->formatting_time = pdf_time(CLOCK_THREAD_CPUTIME_ID) - t - job->compression_time;
+  job->contents_size = job->writer->contents_size - n;
+}
+
+typedef struct
+{
+  pdf_stream_job_t *jobs;
+  int first_job;
+  int n_threads;
+}
+pdf_stream_thread_t;
+
+static void *pdf_stream_thread(void *arg)
+{ // makes the jobs first_job, first_job + n_threads, ...
+  pdf_stream_thread_t *thread = (pdf_stream_thread_t *)arg;
+  int i;
+
+  for(i = thread->first_job;i < 3;i += thread->n_threads)
+    make_pdf_stream(&thread->jobs[i]);
+  return NULL;
+}
+
+//
+// write the three content streams of a page (see above); with pdf_compression_threads > 1 they are made at the same time
+// (the calling thread makes one of them)
+//
+
+static void write_pdf_page_streams(pdf_writer_t *writer,int first_object,int road_size,uint8_t max_road_speed[1 + road_size],int n_moves,int positions[1 + n_moves],double elapsed_time,unsigned long effort,char *title,int all_borders)
+{
+  pdf_stream_thread_t threads[3];
+  pthread_t thread_ids[3];
+  pdf_stream_job_t jobs[3];
+  pdf_page_t page;
+  int i,n_threads;
+  double t;
+
+  t = pdf_time(CLOCK_MONOTONIC);
+  page.road_size = road_size;
+  page.max_road_speed = max_road_speed;
+  page.n_moves = n_moves;
+  page.positions = positions;
+  page.elapsed_time = elapsed_time;
+  page.effort = effort;
+  page.title = title;
+  page.all_borders = all_borders;
+  page.g = 1 + road_size / _n_spiral_cells_;
+  page.last_band = road_size / page.g;
+  n_threads = (pdf_compression_threads < 3) ? pdf_compression_threads : 3;
+  for(i = 0;i < 3;i++)
   {
-    j = i * _oversampling_ + _oversampling_ / 2; // the index corresponding to the center of the cell
-    add_pdf_content(&pdf_objects[6],"1 0 0 1 %.3f %.3f Tm (%d) Tj\n",figure_x(spiral_points[j].x) - 0.3 * s0,figure_y(spiral_points[j].y) - 0.35 * s0,max_road_speed[i]);
-  }
-  add_pdf_content(&pdf_objects[6],"ET");
-  //
-  // dump the PDF file (warning, no tests are performed to check if individual writes fail)
-  //
-  file_offset = fprintf(fp,"%%PDF-1.4\n");
-  file_offset += fprintf(fp,"%%\xC3\xA1\xC3\xA1\n");
-  for(i = 0;i < n_pdf_objects;i++)
-    if(pdf_objects[i].contents != NULL)
+    jobs[i].page = &page;
+    jobs[i].stream = i;
+    jobs[i].writer = (n_threads > 1) ? new_pdf_writer() : writer;
+  }
+  if(n_threads <= 1)
+  { // one after the other, directly to the file
+    for(i = 0;i < 3;i++)
     {
-      // remove \n at the end of the contents (because one will be added automatically below)
-      for(j = (int)strlen(pdf_objects[i].contents);j >= 1 && pdf_objects[i].contents[j - 1] == '\n';j--)
-        pdf_objects[i].contents[j - 1] = '\0';
-      // dump the object
-      pdf_objects[i].file_offset = file_offset;
-      file_offset += fprintf(fp,"%d 0 obj\n",1 + i);
-      switch(pdf_objects[i].type)
+      write_pdf_stream_header(writer,first_object + i,first_object + 3 + i);
+      make_pdf_stream(&jobs[i]);
+      write_pdf_stream_trailer(writer,jobs[i].length,first_object + 3 + i);
+    }
+  }
+  else
+  { // at the same time, to memory, and then to the file
+    for(i = 0;i < n_threads;i++)
+    {
+      threads[i].jobs = jobs;
+      threads[i].first_job = i;
+      threads[i].n_threads = n_threads;
+    }
+    for(i = 1;i < n_threads;i++)
+      if(pthread_create(&thread_ids[i],NULL,pdf_stream_thread,&threads[i]) != 0)
       {
-        case is_pdf_object:
-          file_offset += fprintf(fp,"%s\n",pdf_objects[i].contents);
-          break;
-        case is_pdf_stream:
+        fprintf(stderr,"write_pdf_page_streams: unable to create thread\n");
+        exit(1);
+      }
+    (void)pdf_stream_thread(&threads[0]);
+    for(i = 1;i < n_threads;i++)
+      pthread_join(thread_ids[i],NULL);
+    for(i = 0;i < 3;i++)
+    {
+      flush_pdf_writer(jobs[i].writer);
+      write_pdf_stream_header(writer,first_object + i,first_object + 3 + i);
+      write_pdf_bytes(writer,jobs[i].writer->memory,(int)jobs[i].length);
+      write_pdf_stream_trailer(writer,jobs[i].length,first_object + 3 + i);
+      free_pdf_writer(jobs[i].writer);
+    }
+  }
+  t = pdf_time(CLOCK_MONOTONIC) - t;
+  pthread_mutex_lock(&pdf_statistics_lock);
+  pdf_statistics.n_pages++;
+  pdf_statistics.page_time += t;
+  for(i = 0;i < 3;i++)
+  {
+    pdf_statistics.formatting_time += jobs[i].formatting_time;
+    pdf_statistics.compression_time += jobs[i].compression_time;
+    pdf_statistics.contents_size += jobs[i].contents_size;
+    pdf_statistics.streams_size += jobs[i].length;
+  }
+  pthread_mutex_unlock(&pdf_statistics_lock);
+}
+
+
+//
+// the public PDF stuff
+//
+
+void make_custom_pdf_file(char *pdf_file_name,int road_size,uint8_t max_road_speed[1 + road_size],int n_moves,int positions[1 + n_moves],double elapsed_time,unsigned long effort,char *title)
+{
+  pdf_writer_t *writer;
+
+  writer = open_pdf_writer(pdf_file_name,"make_custom_pdf_file");
+  pthread_once(&spiral_geometry_once,init_spiral_geometry); // get the (cached) spiral and coordinate transformation data
+  // the catalog (object #1)
+  begin_pdf_object(writer,1);
+  write_pdf_text(writer,"<< /Type /Catalog /Pages 2 0 R >>\n");
+  end_pdf_object(writer);
+  // the list of pages (object #2)
+  begin_pdf_object(writer,2);
+  write_pdf_text(writer,"<< /Type /Pages /Kids [3 0 R] /Count 1 >>\n");
+  end_pdf_object(writer);
+  // the description of the page (object #3)
+  begin_pdf_object(writer,3);
+  write_pdf_text(writer,"<< /Type /Page /Parent 2 0 R /MediaBox [0 0 %d %d] /Contents [5 0 R 6 0 R 7 0 R] /Resources << /Font << /MyFont 4 0 R >> /ProcSet [/PDF /Text] >> >>\n",_figure_width_,_figure_height_);
+  end_pdf_object(writer);
+  // the font used by the page (object #4)
+  begin_pdf_object(writer,4);
+  write_pdf_text(writer,"<< /Type /Font /Subtype /Type1 /Name /MyFont /BaseFont /Courier-Bold /Encoding /StandardEncoding >>\n");
+  end_pdf_object(writer);
+  // the spiral cell highlights, the spiral cell borders, and the speed data (objects #5, #6, and #7, with lengths #8, #9, and #10)
+  write_pdf_page_streams(writer,5,road_size,max_road_speed,n_moves,positions,elapsed_time,effort,title,1);
+  close_pdf_writer(writer);
+}
+
+
+//
+// compression settings: "level[:strategy[:n_threads]]", with level 0 (none) to 9 (best), strategy default, filtered,
+// huffman, rle, or fixed (see deflateInit2() in /usr/include/zlib.h), and 1 to 3 threads; returns 0 if all is well
+// (it should be called before any PDF file is made); without zlib only "0[::n_threads]" is accepted
+//
+
+int set_pdf_compression(const char *settings)
+{
+  char strategy[16];
+  int level,n_threads,i,n;
+
+  strategy[0] = '\0';
+  n_threads = pdf_compression_threads;
+  n = sscanf(settings,"%d:%15[a-z]:%d",&level,strategy,&n_threads);
+  if(n < 2 && sscanf(settings,"%d::%d",&level,&n_threads) == 2)
+    n = 3; // no strategy given
+  if(n < 1 || level < 0 || level > 9 || n_threads < 1 || n_threads > 3)
+    return -1;
+#if _use_zlib_ == 0
+  if(level != 0 || strategy[0] != '\0')
+  {
+    fprintf(stderr,"set_pdf_compression: compiled without zlib (-D_use_zlib_=0), the PDF files cannot be compressed\n");
+    return -1;
+  }
+#endif
+  if(strategy[0] == '\0')
+    strcpy(strategy,"default");
+  i = 0;
+  if(n >= 2)
+    for(i = 0;i < (int)(sizeof(pdf_compression_strategy_names) / sizeof(pdf_compression_strategy_names[0])) && strcmp(strategy,pdf_compression_strategy_names[i]) != 0;i++)
+      ;
+  if(i == (int)(sizeof(pdf_compression_strategy_names) / sizeof(pdf_compression_strategy_names[0])))
+    return -1;
+  pdf_compression_level = level;
+  pdf_compression_strategy = i;
+  pdf_compression_threads = n_threads;
+  return 0;
+}
+
+void print_pdf_statistics(FILE *fp)
+{ // the compression settings and where the time went
+  pthread_mutex_lock(&pdf_statistics_lock);
 #if _use_zlib_ > 0
-          {
-            // documentation on how to use the zlib compression library in /usr/include/zlib.h
-            size_t buffer_size;
-            unsigned char *buffer;
-            z_stream z;
-
-            // prepare the buffer to hold the compressed data
-            buffer_size = (size_t)strlen(pdf_objects[i].contents);
-            buffer_size += buffer_size / 4;
-            buffer_size += (size_t)1000; // this should be much more than enough space for the compressed data --- could have used the deflateBound() function instead, but that would have to be done after deflateInit()...
-            buffer = (unsigned char *)malloc(buffer_size);
-            if(buffer == NULL)
-            {
-              fprintf(stderr,"make_custom_pdf_file: out of memory\n");
-              exit(1);
-            }
-            // prepare the compressor
-            z.next_in = (unsigned char *)pdf_objects[i].contents;
-            z.avail_in = strlen(pdf_objects[i].contents);
-            z.total_in = 0;
-            z.next_out = buffer;
-            z.avail_out = buffer_size;
-            z.total_out = 0;
-            z.zalloc = Z_NULL;
-            z.zfree = Z_NULL;
-            z.opaque = Z_NULL;
-            // compress (and cleanup the compressor)
-            if(deflateInit(&z,9) != Z_OK)
-            {
-              fprintf(stderr,"make_custom_pdf_file: deflateInit() failed");
-              exit(1);
-            }
-            if(deflate(&z,Z_FINISH) != Z_STREAM_END)
-            {
-              fprintf(stderr,"make_custom_pdf_file: deflate() failed");
-              exit(1);
-            }
-            if(deflateEnd(&z) != Z_OK)
-            {
-              fprintf(stderr,"make_custom_pdf_file: deflateEnd() failed");
-              exit(1);
-            }
-            // output stream
-            file_offset += fprintf(fp,"<< /Length %d /Filter /FlateDecode >> stream\n",(int)z.total_out);
-            file_offset += fwrite((void *)buffer,sizeof(unsigned char),(size_t)z.total_out,fp);
-            file_offset += fprintf(fp,"\nendstream\n");
-            // clean up
-            free(buffer);
-          }
+  fprintf(fp,"PDF figures: %d page%s, compression level %d, strategy %s, %d thread%s\n",pdf_statistics.n_pages,(pdf_statistics.n_pages == 1) ? "" : "s",
+          pdf_compression_level,pdf_compression_strategy_names[pdf_compression_strategy],pdf_compression_threads,(pdf_compression_threads == 1) ? "" : "s");
 #else
-          file_offset += fprintf(fp,"<< /Length %d >> stream\n",(int)strlen(pdf_objects[i].contents));
-          file_offset += fprintf(fp,"%s",pdf_objects[i].contents);
-          file_offset += fprintf(fp,"\nendstream\n");
+  fprintf(fp,"PDF figures: %d page%s, not compressed, %d thread%s\n",pdf_statistics.n_pages,(pdf_statistics.n_pages == 1) ? "" : "s",
+          pdf_compression_threads,(pdf_compression_threads == 1) ? "" : "s");
 #endif
-          break;
-      }
-      file_offset += fprintf(fp,"endobj\n");
+  fprintf(fp,"  formatting  %9.3e s (cpu)\n",pdf_statistics.formatting_time);
+  fprintf(fp,"  compression %9.3e s (cpu)\n",pdf_statistics.compression_time);
+  fprintf(fp,"  streams     %9.3e s (wall)\n",pdf_statistics.page_time);
+  fprintf(fp,"  size        %ld -> %ld bytes\n",pdf_statistics.contents_size,pdf_statistics.streams_size);
+  pthread_mutex_unlock(&pdf_statistics_lock);
+}
+
+
+//
+// report mode: a single multi-page PDF file, with one page per solution
+//
+//   #1 the catalog, #3 the font, and #4 the gray borders of all spiral cells (length in #5) are written by open_pdf_report()
+//   #2 the list of pages is written by close_pdf_report()
+//   each page uses seven more objects (the page description, and its three content streams and their lengths)
+// add_pdf_report_page() can be called by several threads at the same time (the pages are written one at a time);
+// the pages appear in the order of their page_number (starting at 0)
+//
+
+typedef struct
+{
+  pdf_writer_t *writer;
+  int max_pages;     // the size of the page_objects array
+  int *page_objects; // the object number of each page (0 if none)
+  pthread_mutex_t lock;
+}
+pdf_report_t;
+
+pdf_report_t *open_pdf_report(char *pdf_file_name)
+{
+  const spiral_point_t *spiral_points;
+  pdf_stream_t pdf_stream;
+  pdf_report_t *report;
+  int i,n;
+
+  report = (pdf_report_t *)calloc(1,sizeof(pdf_report_t));
+  if(report == NULL)
+  {
+    fprintf(stderr,"open_pdf_report: out of memory\n");
+    exit(1);
+  }
+  report->writer = open_pdf_writer(pdf_file_name,"open_pdf_report");
+  pthread_mutex_init(&report->lock,NULL);
+  pthread_once(&spiral_geometry_once,init_spiral_geometry);
+  // the catalog (object #1)
+  begin_pdf_object(report->writer,1);
+  write_pdf_text(report->writer,"<< /Type /Catalog /Pages 2 0 R >>\n");
+  end_pdf_object(report->writer);
+  // the font used by all pages (object #3)
+  begin_pdf_object(report->writer,3);
+  write_pdf_text(report->writer,"<< /Type /Font /Subtype /Type1 /Name /MyFont /BaseFont /Courier-Bold /Encoding /StandardEncoding >>\n");
+  end_pdf_object(report->writer);
+  // the gray borders of all spiral cells (object #4, length in object #5); each page draws its black ones on top of them
+  {
+    const double figure_scale = spiral_geometry.figure_scale,figure_x_offset = spiral_geometry.figure_x_offset,figure_y_offset = spiral_geometry.figure_y_offset;
+
+    spiral_points = spiral_geometry.points;
+    n = _oversampling_ * _n_spiral_cells_;
+    write_pdf_stream_header(report->writer,4,5);
+    begin_pdf_stream(report->writer,&pdf_stream);
+    add_pdf_content(&pdf_stream,"0.8 0.8 0.8 RG 0.4 w\n"); // stroke color is gray, linewidth is 0.4pt
+    add_pdf_content(&pdf_stream,"%.3f %.3f m %.3f %.3f l S\n",figure_x(spiral_points[0].x_in),figure_y(spiral_points[0].y_in),figure_x(spiral_points[0].x_out),figure_y(spiral_points[0].y_out));
+    for(i = 0;i < n;i += _oversampling_)
+      add_pdf_cell(&pdf_stream,&spiral_points[i]," S\n");
+    write_pdf_stream_trailer(report->writer,end_pdf_stream(&pdf_stream),5);
+  }
+  flush_pdf_writer(report->writer);
+  return report;
+}
+
+void add_pdf_report_page(pdf_report_t *report,int page_number,int road_size,uint8_t max_road_speed[1 + road_size],int n_moves,int positions[1 + n_moves],double elapsed_time,unsigned long effort,char *title)
+{
+  int i,object_number;
+
+  if(page_number < 0)
+  {
+    fprintf(stderr,"add_pdf_report_page: bad page number\n");
+    exit(1);
+  }
+  pthread_mutex_lock(&report->lock);
+  object_number = report->writer->n_pdf_objects + 1; // object #2 is written last, so this is at least 6
+  begin_pdf_object(report->writer,object_number);
+  write_pdf_text(report->writer,"<< /Type /Page /Parent 2 0 R /MediaBox [0 0 %d %d] /Contents [%d 0 R 4 0 R %d 0 R %d 0 R] /Resources << /Font << /MyFont 3 0 R >> /ProcSet [/PDF /Text] >> >>\n",_figure_width_,_figure_height_,object_number + 1,object_number + 2,object_number + 3);
+  end_pdf_object(report->writer);
+  write_pdf_page_streams(report->writer,object_number + 1,road_size,max_road_speed,n_moves,positions,elapsed_time,effort,title,0);
+  flush_pdf_writer(report->writer);
+  if(page_number >= report->max_pages)
+  {
+    i = report->max_pages;
+    report->max_pages = 2 * page_number + 16;
+    report->page_objects = (int *)realloc(report->page_objects,(size_t)report->max_pages * sizeof(int));
+    if(report->page_objects == NULL)
+    {
+      fprintf(stderr,"add_pdf_report_page: out of memory\n");
+      exit(1);
     }
-  fprintf(fp,"xref\n");
-  fprintf(fp,"0 %d\n",n_pdf_objects + 1);
-  fprintf(fp,"0000000000 65535 f \n"); // note the space before the new line!
-  for(i = 0;i < n_pdf_objects;i++)
-    fprintf(fp,"%010d 00000 n \n",pdf_objects[i].file_offset);
-  fprintf(fp,"trailer << /Size %d /Root 1 0 R /ID [<AED02022> <AED02022>]>>\n",1 + n_pdf_objects);
-  fprintf(fp,"startxref\n");
-  fprintf(fp,"%d\n",file_offset);
-  fprintf(fp,"%%%%EOF\n");
-  //
+    for(;i < report->max_pages;i++)
+      report->page_objects[i] = 0;
+  }
+  report->page_objects[page_number] = object_number;
+  pthread_mutex_unlock(&report->lock);
+}
+
+void close_pdf_report(pdf_report_t *report)
+{
+  int i,n_pages;
+
+  // the list of pages (object #2)
+  begin_pdf_object(report->writer,2);
+  write_pdf_text(report->writer,"<< /Type /Pages /Kids [");
+  for(i = n_pages = 0;i < report->max_pages;i++)
+    if(report->page_objects[i] != 0)
+      write_pdf_text(report->writer,"%s%d 0 R",(n_pages++ == 0) ? "" : " ",report->page_objects[i]);
+  write_pdf_text(report->writer,"] /Count %d >>\n",n_pages);
+  end_pdf_object(report->writer);
+  close_pdf_writer(report->writer);
   // clean up
-  fclose(fp);
-  for(i = 0;i < n_pdf_objects;i++)
-    if(pdf_objects[i].contents_max_size > 0)
-      free(pdf_objects[i].contents);
+  pthread_mutex_destroy(&report->lock);
+  free(report->page_objects);
+  free(report);
+}
+
 # undef figure_x
 # undef figure_y
-}
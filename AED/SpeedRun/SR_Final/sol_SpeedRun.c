@@ -4,9 +4,12 @@
 // First practical assignement (speed run)
 //
 // Compile using either
-//   cc -Wall -O2 -D_use_zlib_=0 solution_speed_run.c -lm
+//   cc -Wall -O2 -pthread -D_use_zlib_=0 sol_SpeedRun.c -lm
 // or
-//   cc -Wall -O2 -D_use_zlib_=1 solution_speed_run.c -lm -lz
+//   cc -Wall -O2 -pthread -D_use_zlib_=1 sol_SpeedRun.c -lm -lz
+// (add -mavx2, or -march=native, to use the AVX2 code of the bit-parallel solver)
+// (add -D_use_processes_=1 ../../../SO/JantarDeAmigos/src/semaphore.c ../../../SO/JantarDeAmigos/src/sharedMemory.c to
+//  use the multi-process sweep, option -m)
 //
 // Place your student numbers and names here
 //   N.Mec. XXXXXX  Name: XXXXXXX
@@ -17,9 +20,15 @@
 // static configuration
 //
 
-#define _max_road_size_  800  // the maximum problem size
+#define _max_road_size_  800  // the default maximum problem size (it can be changed at run time with the -n option)
 #define _min_road_speed_   2  // must not be smaller than 1, shouldnot be smaller than 2
 #define _max_road_speed_   9  // must not be larger than 9 (only because of the PDF figure)
+#define _max_threads_     64  // the maximum number of worker threads of the parallel sweep (-j option)
+#define _max_processes_   64  // the maximum number of worker processes of the multi-process sweep (-m option)
+
+#ifndef _use_processes_
+# define _use_processes_   0  // a positive value adds the multi-process sweep (it uses the SysV IPC modules of SO/JantarDeAmigos)
+#endif
 
 
 //
@@ -28,32 +37,194 @@
 
 #include <math.h>
 #include <stdio.h>
-#include "../P02/elapsed_time.h"
+#include <stdint.h>
+#include <pthread.h>
+#ifdef __AVX2__
+# include <immintrin.h>
+#endif
+#include "elapsed_time.h"
 #include "make_custom_pdf.c"
+#include "solution_log.h"
+
+
+//
+// memory allocation (all problem-size dependent data lives on the heap)
+//
+
+static void *alloc_memory(size_t n_elements,size_t element_size)
+{
+  void *p;
+
+  p = calloc((n_elements > 0) ? n_elements : 1,element_size);
+  if(p == NULL)
+  {
+    fprintf(stderr,"alloc_memory: out of memory\n");
+    exit(1);
+  }
+  return p;
+}
+
+
+//
+// tracing (--trace option): a ring buffer of begin/end/counter events, written at exit in the Chrome trace format
+//
+//  Com o tracing desligado cada ponto de trace custa apenas o teste de trace_events == NULL. Os
+// eventos são guardados num buffer circular (os mais antigos são substituídos quando enche),
+// reservando cada posição com uma operação atómica, pelo que várias threads podem registar
+// eventos ao mesmo tempo. O ficheiro JSON pode ser aberto em https://ui.perfetto.dev ou em
+// chrome://tracing.
+//
+
+#define _trace_capacity_  (1 << 16)  // must be a power of two
+
+typedef struct
+{
+  double time;        // wall time (seconds)
+  const char *name;   // must be a string constant
+  char phase;         // 'B' (begin), 'E' (end) or 'C' (counter)
+  int thread;
+  long value;         // the final_position ('B' and 'E' events) or the value of the counter ('C' events)
+}
+trace_event_t;
+
+static trace_event_t *trace_events;     // NULL when tracing is disabled
+static unsigned long trace_n_events;    // the total number of events recorded (the buffer keeps the last _trace_capacity_ of them)
+static char *trace_file_name;
+static int trace_n_threads;
+static __thread int trace_thread = -1;
+
+static void trace_record(const char *name,char phase,long value)
+{
+  trace_event_t *e;
+
+  if(trace_thread < 0)
+    trace_thread = __atomic_fetch_add(&trace_n_threads,1,__ATOMIC_RELAXED);
+  e = &trace_events[__atomic_fetch_add(&trace_n_events,1ul,__ATOMIC_RELAXED) & (_trace_capacity_ - 1)];
+  e->time = wall_time();
+  e->name = name;
+  e->phase = phase;
+  e->thread = trace_thread;
+  e->value = value;
+}
+
+#define trace_begin(name,value)    do { if(trace_events != NULL) trace_record((name),'B',(long)(value)); } while(0)
+#define trace_end(name,value)      do { if(trace_events != NULL) trace_record((name),'E',(long)(value)); } while(0)
+#define trace_counter(name,value)  do { if(trace_events != NULL) trace_record((name),'C',(long)(value)); } while(0)
+
+static void write_trace(void)
+{ // called at exit
+  unsigned long i,first;
+  trace_event_t *e;
+  double t0;
+  FILE *fp;
+
+  fp = fopen(trace_file_name,"w");
+  if(fp == NULL)
+  {
+    fprintf(stderr,"write_trace: unable to create file %s\n",trace_file_name);
+    return;
+  }
+  first = (trace_n_events > _trace_capacity_) ? trace_n_events - _trace_capacity_ : 0ul;
+  t0 = (trace_n_events > 0ul) ? trace_events[first & (_trace_capacity_ - 1)].time : 0.0;
+  fprintf(fp,"{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+  for(i = first;i < trace_n_events;i++)
+  {
+    e = &trace_events[i & (_trace_capacity_ - 1)];
+    fprintf(fp,"{\"name\":\"%s\",\"ph\":\"%c\",\"ts\":%.3f,\"pid\":1,\"tid\":%d,\"args\":{\"%s\":%ld}}%s\n",
+            e->name,e->phase,1.0e6 * (e->time - t0),e->thread,(e->phase == 'C') ? "value" : "n",e->value,(i + 1 < trace_n_events) ? "," : "");
+  }
+  fprintf(fp,"]}\n");
+  fclose(fp);
+  free(trace_events);
+  trace_events = NULL;
+}
+
+static void init_trace(char *file_name)
+{
+  trace_file_name = file_name;
+  trace_events = (trace_event_t *)alloc_memory(_trace_capacity_,sizeof(trace_events[0]));
+  atexit(write_trace);
+}
 
 
 //
 // road stuff
 //
 
-static int max_road_speed[1 + _max_road_size_]; // positions 0.._max_road_size_
+static int max_road_size = _max_road_size_; // the maximum problem size (positions 0..max_road_size)
+
+typedef struct
+{
+  int seed;                 // the n_mec given to srandom() before the road was generated
+  uint8_t *max_road_speed;  // positions 0..max_road_size
+  uint16_t *legal_speeds;   // bit s is set when moving from a position with speed s is legal (all speed limits of the window are >= s)
+  int n_segments;           // run-length encoding: segment k has the constant speed limit max_road_speed[segment_start[k]]
+  int *segment_start;       // at positions segment_start[k]..segment_start[k + 1] - 1 (segment_start[n_segments] = max_road_size + 1)
+}
+road_t;
+
+static road_t road;         // the road of the sweep
+
+#define is_legal_move(legal_speeds,position,speed)  (((legal_speeds)[position] >> (speed)) & 1)
 
-static void init_road_speeds(void)
+static void init_road_speeds(road_t *r,int seed)
 {
+  uint8_t *max_road_speed;
+  uint16_t *legal_speeds;
   double speed;
-  int i;
+  int i,s,v,min_speed;
 
-  for(i = 0;i <= _max_road_size_;i++)
+  srandom((unsigned int)seed);
+  r->seed = seed;
+  if(r->max_road_speed == NULL)
+  {
+    r->max_road_speed = (uint8_t *)alloc_memory((size_t)max_road_size + 1,sizeof(r->max_road_speed[0]));
+    r->legal_speeds = (uint16_t *)alloc_memory((size_t)max_road_size + 1,sizeof(r->legal_speeds[0]));
+    r->segment_start = (int *)alloc_memory((size_t)max_road_size + 2,sizeof(r->segment_start[0]));
+  }
+  max_road_speed = r->max_road_speed;
+  legal_speeds = r->legal_speeds;
+  for(i = 0;i <= max_road_size;i++)
   {
     speed = (double)_max_road_speed_ * (0.55 + 0.30 * sin(0.11 * (double)i) + 0.10 * sin(0.17 * (double)i + 1.0) + 0.15 * sin(0.19 * (double)i));
-    max_road_speed[i] = (int)floor(0.5 + speed) + (int)((unsigned int)random() % 3u) - 1;
-    if(max_road_speed[i] < _min_road_speed_)
-      max_road_speed[i] = _min_road_speed_;
-    if(max_road_speed[i] > _max_road_speed_)
-      max_road_speed[i] = _max_road_speed_;
+    v = (int)floor(0.5 + speed) + (int)((unsigned int)random() % 3u) - 1;
+    if(v < _min_road_speed_)
+      v = _min_road_speed_;
+    if(v > _max_road_speed_)
+      v = _max_road_speed_;
+    max_road_speed[i] = (uint8_t)v;
+  }
+  // the segments of constant speed limit
+  r->n_segments = 0;
+  for(i = 0;i <= max_road_size;i++)
+    if(i == 0 || max_road_speed[i] != max_road_speed[i - 1])
+      r->segment_start[r->n_segments++] = i;
+  r->segment_start[r->n_segments] = max_road_size + 1;
+  // precompute the legality of all moves (the window of a move with speed s starting at i is i..i+s)
+  for(i = 0;i <= max_road_size;i++)
+  {
+    legal_speeds[i] = 0;
+    min_speed = max_road_speed[i];
+    for(s = 1;s <= _max_road_speed_ && i + s <= max_road_size;s++)
+    {
+      if(max_road_speed[i + s] < min_speed)
+        min_speed = max_road_speed[i + s];
+      if(s <= min_speed)
+        legal_speeds[i] |= (uint16_t)(1u << s);
+    }
   }
 }
 
+static void free_road(road_t *r)
+{
+  free(r->max_road_speed);
+  free(r->legal_speeds);
+  free(r->segment_start);
+  r->max_road_speed = NULL;
+  r->legal_speeds = NULL;
+  r->segment_start = NULL;
+}
+
 
 //
 // description of a solution
@@ -61,27 +232,122 @@ static void init_road_speeds(void)
 
 typedef struct
 {
-  int n_moves;                         // the number of moves (the number of positions is one more than the number of moves)
-  int positions[1 + _max_road_size_];  // the positions (the first one must be zero)
+  int n_moves;    // the number of moves (the number of positions is one more than the number of moves)
+  int *positions; // the positions (the first one must be zero), room for 1 + max_road_size of them
 }
 solution_t;
 
+static void init_solution(solution_t *solution)
+{
+  if(solution->positions == NULL)
+    solution->positions = (int *)alloc_memory((size_t)max_road_size + 1,sizeof(solution->positions[0]));
+  solution->n_moves = 0;
+}
+
 
 //
-// the (very inefficient) recursive solution given to the students
+// solver state
 //
+//  Todo o estado de um solver está nesta estrutura, para que cada tarefa (e cada thread do
+// varrimento paralelo) tenha o seu próprio estado. Os arrays de trabalho de cada método só são
+// alocados na primeira vez que esse método é usado.
+//
+
+#define _sweep_window_  16  // must be a power of two larger than _max_road_speed_
+
+typedef struct
+{
+  int position;
+  int8_t speed;
+  int8_t next_speed;   // the next speed to try (speed + 1 down to speed - 1)
+  int8_t improved;     // the best solution improved below this frame
+}
+bb_frame_t;            // a frame of the explicit stack of the iterative branch-and-bound solver (8 bytes)
 
-static solution_t solution_1,solution_1_best;
-static double solution_1_elapsed_time; // time it took to solve the problem
-static unsigned long solution_1_count; // effort dispended solving the problem
+typedef struct
+{
+  const uint16_t *legal_speeds;  // the legality table of the road being solved
+  const road_t *road;            // the road being solved (the macro-move solver uses its segments)
+  solution_t best;               // the best solution found
+  double elapsed_time;           // time it took to solve the problem
+  unsigned long count;           // effort dispended solving the problem
+  int *minSaltos;                // pruning data of solver 2 (see below)
+  int *maxVelocidade;
+  bb_frame_t *bb_stack;          // iterative branch-and-bound data (one frame per move)
+  int8_t *dp_from;               // dynamic programming data
+  int *dp_queue_position;
+  int8_t *dp_queue_speed;
+  int sweep_moves[_sweep_window_ * (1 + _max_road_speed_)]; // incremental sweep data
+  int8_t *sweep_from;
+  int sweep_last_position;
+  int *astar_g;                  // A* data (number of moves of each state, -1 when not yet reached)
+  int8_t *astar_from;
+  void *astar_heap;
+  size_t astar_heap_max_size;
+  int *bidir_dist[2];            // bidirectional search data (index 0 is the forward search, 1 the backward one)
+  int8_t *bidir_link[2];         // the speed of the previous state (forward) or of the next state (backward)
+  int *bidir_queue_position[2];
+  int8_t *bidir_queue_speed[2];
+  uint64_t *bits;                // bit-parallel BFS data (see solve_bits)
+  int *bits_moves;               // number of moves to reach (position,1), -1 when not yet known
+  int bits_depth;                // number of moves of the states of the frontier (-1 after a reset)
+  int bits_first_word;           // the frontier lives in words bits_first_word..bits_last_word
+  int bits_last_word;
+}
+solver_state_t;
+
+static void reset_sweep(solver_state_t *state);
+
+static void init_solver_state(solver_state_t *state,road_t *r)
+{
+  memset(state,0,sizeof(*state));
+  state->legal_speeds = r->legal_speeds;
+  state->road = r;
+  init_solution(&state->best);
+  reset_sweep(state);
+}
+
+static void free_solver_state(solver_state_t *state)
+{
+  free(state->best.positions);
+  free(state->minSaltos);
+  free(state->maxVelocidade);
+  free(state->bb_stack);
+  free(state->dp_from);
+  free(state->dp_queue_position);
+  free(state->dp_queue_speed);
+  free(state->sweep_from);
+  free(state->astar_g);
+  free(state->astar_from);
+  free(state->astar_heap);
+  free(state->bits);
+  free(state->bits_moves);
+  for(int i = 0;i < 2;i++)
+  {
+    free(state->bidir_dist[i]);
+    free(state->bidir_link[i]);
+    free(state->bidir_queue_position[i]);
+    free(state->bidir_queue_speed[i]);
+  }
+  memset(state,0,sizeof(*state));
+}
+
+
+//
+// the (very inefficient) recursive solution given to the students
+//
+//  Os solvers recursivos não guardam o caminho atual nem o copiam quando encontram uma solução
+// melhor: cada chamada devolve 1 se a melhor solução melhorou dentro dela e, nesse caso, escreve
+// a sua posição em best.positions[move_number] ao regressar. Como só os antepassados da última
+// melhoria ainda o fazem depois dela, no fim best.positions[] tem exatamente o melhor caminho.
+//
 
-static void solution_1_recursion(int move_number,int position,int speed,int final_position)
+static int solution_1_recursion(solver_state_t *state,int move_number,int position,int speed,int final_position)
 {
-  int i,new_speed;
+  int new_speed,improved;
 
   // record move
-  solution_1_count++;
-  solution_1.positions[move_number] = position;
+  state->count++;
 
 
 
@@ -89,12 +355,13 @@ static void solution_1_recursion(int move_number,int position,int speed,int fina
   if(position == final_position && speed == 1)
   {
     // is it a better solution?
-    if(move_number < solution_1_best.n_moves)
+    if(move_number < state->best.n_moves)
     {
-      solution_1_best = solution_1;
-      solution_1_best.n_moves = move_number;
+      state->best.n_moves = move_number;
+      state->best.positions[move_number] = position;
+      return 1;
     }
-    return;
+    return 0;
   }
 
 
@@ -102,262 +369,2302 @@ static void solution_1_recursion(int move_number,int position,int speed,int fina
 
 
   // no, try all legal speeds
+  improved = 0;
   for(new_speed = speed - 1;new_speed <= speed + 1;new_speed++) {
     if(new_speed >= 1 && new_speed <= _max_road_speed_ && position + new_speed <= final_position)
     {
-      for(i = 0;i <= new_speed && new_speed <= max_road_speed[position + i];i++);
-      if(i > new_speed)
-        solution_1_recursion(move_number + 1,position + new_speed,new_speed,final_position);
+      if(is_legal_move(state->legal_speeds,position,new_speed))
+        improved |= solution_1_recursion(state,move_number + 1,position + new_speed,new_speed,final_position);
     }
   }
+  // record move (only on the way back from a better solution)
+  if(improved != 0)
+    state->best.positions[move_number] = position;
+  return improved;
 }
 
 
-static void solve_1(int final_position)
+static void solve_1(solver_state_t *state,int final_position)
 {
-  if(final_position < 1 || final_position > _max_road_size_)
+  if(final_position < 1 || final_position > max_road_size)
   {
     fprintf(stderr,"solve_1: bad final_position\n");
     exit(1);
   }
-  solution_1_elapsed_time = cpu_time();
-  solution_1_count = 0ul;
-  solution_1_best.n_moves = final_position + 100;
-  solution_1_recursion(0,0,0,final_position);
-  solution_1_elapsed_time = cpu_time() - solution_1_elapsed_time;
+  state->elapsed_time = thread_cpu_time();
+  state->count = 0ul;
+  state->best.n_moves = final_position + 100;
+  (void)solution_1_recursion(state,0,0,0,final_position);
+  state->elapsed_time = thread_cpu_time() - state->elapsed_time;
 }
 
 //
 //  FUNC FINAL
 //
+//  Usa dois arrays do estado do solver:
+//
+//  minSaltos      Array com o numero mínimo de passos precisos para chegar a cada posição
+//                  Ex: se chegar à posição 14 em 5 saltos, minSaltos[14] = 5;
+//                  Se noutra iteração chegar em 7 saltos, o programa acaba com o ramo;
+//                  Se chegar com 4 saltos o programa começa a usar esse ramo com o principal;
+//
+//  maxVelocidade  Mesma coisa do que o Array de cima, mas desta vez conta a velocidade a que se
+//                 chega a cada posição. Só serve para "desempatar" ramos que podem ter chegado com
+//                 o mesmo número de saltos mas diferentes velocidades.
+//                  Ex: Se 2 ramos chegarem com 6 saltos à posição 16, o que tiver mais velocidade
+//                 contínua, caso sejam a mesma, ambos ramos continuam até se desempatarem noutra
+//                 posição
+//
 
 
-static solution_t solution_2,solution_2_best;
-static double solution_2_elapsed_time;          // time it took to solve the problem
-static unsigned long solution_2_count;           // effort dispended solving the problem
-
-static int minSaltos[_max_road_size_];          //  Array com o numero mínimo de passos precisos para chegar a cada 
-                                                // posição
-                                                //  Ex: se chegar à posição 14 em 5 saltos, minSaltos[14] = 5;
-                                                //  Se noutra iteração chegar em 7 saltos, o programa acaba com o 
-                                                // ramo;
-                                                //  Se chegar com 4 saltos o programa começa a usar esse ramo com o 
-                                                // principal;
-
-static int maxVelocidade[_max_road_size_];      //  Mesma coisa do que o Array de cima, mas desta vez conta a 
-                                                // velocidade a que se chega a cada posição. Só serve para 
-                                                // "desempatar" ramos que podem ter chegado com o mesmo
-                                                // número de saltos mas diferentes velocidades.
-                                                //  Ex: Se 2 ramos chegarem com 6 saltos à posição 16, o que 
-                                                // tiver mais velocidade contínua, caso sejam a mesma, ambos
-                                                // ramos continuam até se desempatarem noutra posição
-
+static int solution_2_recursion(solver_state_t *state,int move_number,int position,int speed,int final_position) {
 
-static void solution_2_recursion(int move_number,int position,int speed,int final_position) {
-  
 
-  int i,new_speed;
+  int new_speed,improved;
 
   // record move
-  solution_2_count++;
-  solution_2.positions[move_number] = position;
+  state->count++;
 
-  //  Ver se é solução. Neste código chegar a uma solução implica que é 
+  //  Ver se é solução. Neste código chegar a uma solução implica que é
   // sempre a melhor, pois náo foi cortada antes de lá chegar
   if(position == final_position && speed == 1) {
     // this solution is always the best
-    solution_2_best = solution_2;
-    solution_2_best.n_moves = move_number;
-    return;
+    state->best.n_moves = move_number;
+    state->best.positions[move_number] = position;
+    return 1;
   }
 
+  improved = 0;
+
   // Como náo é solução, podemos continuar o código
   for(new_speed = speed + 1;new_speed >= speed - 1;new_speed--) {
 
-    if(new_speed > 0 && new_speed <= max_road_speed[position + new_speed] && position + new_speed <= final_position) {
-      
-      for(i = 0;i <= new_speed && new_speed <= max_road_speed[position + i];i++);
+    if(new_speed > 0 && new_speed <= _max_road_speed_ && position + new_speed <= final_position) {
+
+      if(is_legal_move(state->legal_speeds,position,new_speed)) {
 
-      if(i > new_speed) {
-      
         //  Este é o código simples que verifica se vale a pena continuar o ramo ou não
-        //  Apenas começa a cortar ramos se já houver pelo menos uma solução 
-        // (assim garantimos sempre uma solução, sem isto pode haver problemas 
+        //  Apenas começa a cortar ramos se já houver pelo menos uma solução
+        // (assim garantimos sempre uma solução, sem isto pode haver problemas
         // para alguns final_positions)
 
-        //  Como o primeiro ramo vai sempre pelas velocidades mais altas possíveis (menos no fim), 
+        //  Como o primeiro ramo vai sempre pelas velocidades mais altas possíveis (menos no fim),
         // há uma grande chance de ser o melhor, mas não podemos assumir isso.
 
-        //  O ramo é cortado caso já se tenha passado pela mesma posição com um número menor de 
-        // movimentos ou maior velocidade num ramo anterior, logo qualquer solução nova é 
+        //  O ramo é cortado caso já se tenha passado pela mesma posição com um número menor de
+        // movimentos ou maior velocidade num ramo anterior, logo qualquer solução nova é
         // intrínsecamente melhor que a anterior, pois não foi cortada até chegar ao fim.
-    
-        if (solution_2.positions[solution_2_best.n_moves] != 0){
-          if (new_speed <= maxVelocidade[position+new_speed] &&
-              move_number+1 >= minSaltos[position+new_speed]) {
+
+        if (state->best.n_moves <= final_position){
+          if (new_speed <= state->maxVelocidade[position+new_speed] &&
+              move_number+1 >= state->minSaltos[position+new_speed]) {
             continue;
           }
-        }            
+        }
 
-        //  Como o ramo continuou, podemos afirmar que o numero de passos utilizados 
-        // para chegar a esta posição é o menor até agora e que a velocidade com que 
-        // lá chegamos é a menor de todas as iterações anteriores, logo podemos atualizar 
+        //  Como o ramo continuou, podemos afirmar que o numero de passos utilizados
+        // para chegar a esta posição é o menor até agora e que a velocidade com que
+        // lá chegamos é a menor de todas as iterações anteriores, logo podemos atualizar
         // os valores do número de saltos minimos e velocidade máxima desta posição e de
         // todas as posições intermédias por que passa-mos.
 
         // Posição atual
-        minSaltos[position] = move_number+1;
-        maxVelocidade[position] = speed;
+        state->minSaltos[position] = move_number+1;
+        state->maxVelocidade[position] = speed;
 
         // Posições intermédias
         for (int n = 1; n < new_speed; n++) {
-          minSaltos[position+n] = move_number+1;
-          maxVelocidade[position+n] = new_speed;
+          state->minSaltos[position+n] = move_number+1;
+          state->maxVelocidade[position+n] = new_speed;
         }
 
         // próximos ramos
-        solution_2_recursion(move_number + 1,position + new_speed,new_speed,final_position);
+        improved |= solution_2_recursion(state,move_number + 1,position + new_speed,new_speed,final_position);
       }
     }
   }
+
+  // guardar a posição só quando se volta de uma solução melhor
+  if(improved != 0)
+    state->best.positions[move_number] = position;
+  return improved;
+}
+
+static void init_pruning(solver_state_t *state,int final_position)
+{
+  if(state->minSaltos == NULL)
+  {
+    state->minSaltos = (int *)alloc_memory((size_t)max_road_size + 1,sizeof(state->minSaltos[0]));
+    state->maxVelocidade = (int *)alloc_memory((size_t)max_road_size + 1,sizeof(state->maxVelocidade[0]));
+  }
+  memset( state->minSaltos, 0x7f, final_position*sizeof(state->minSaltos[0]));     // um número de saltos muito grande
+  memset( state->maxVelocidade, 0, final_position*sizeof(state->maxVelocidade[0]) );
 }
 
-static void solve_2(int final_position)
+static void solve_2(solver_state_t *state,int final_position)
 {
-  if(final_position < 1 || final_position > _max_road_size_)
+  if(final_position < 1 || final_position > max_road_size)
   {
     fprintf(stderr,"solve_1: bad final_position\n");
     exit(1);
-  }  
-  memset( minSaltos, _max_road_size_, final_position*sizeof(minSaltos[0]));
-  memset( maxVelocidade, 0, final_position*sizeof(maxVelocidade[0]) );
-  memset( solution_2.positions, 0, final_position*sizeof(solution_2.positions[0]));
-  solution_2_elapsed_time = cpu_time();
-  solution_2_count = 0ul;
-  solution_2_best.n_moves = final_position + 100;
-  solution_2_recursion(0,0,0,final_position);
-  solution_2_elapsed_time = cpu_time() - solution_2_elapsed_time;
+  }
+  init_pruning(state,final_position);
+  state->elapsed_time = thread_cpu_time();
+  state->count = 0ul;
+  state->best.n_moves = final_position + 100;
+  (void)solution_2_recursion(state,0,0,0,final_position);
+  state->elapsed_time = thread_cpu_time() - state->elapsed_time;
 }
 
 
-
 //
-// example of the slides
+// FUNC FINAL, iterative version (explicit stack)
+//
+//  Faz exatamente o mesmo que solution_2_recursion() (os mesmos cortes com minSaltos e
+// maxVelocidade, pela mesma ordem, logo o mesmo esforço), mas sem recursão: a pilha tem um
+// frame compacto (posição, velocidade, próxima velocidade a tentar) por movimento, guardado no
+// heap, pelo que funciona para estradas com milhões de posições sem aumentar o limite da stack,
+// e evita o custo de uma chamada de função por nó.
 //
 
-static void example(void)
+static void solve_bb(solver_state_t *state,int final_position)
 {
-  int i,final_position;
+  bb_frame_t *stack,*top;
+  int position,new_speed,move_number,n;
+  int *minSaltos,*maxVelocidade;
 
-  srandom(0xAED2022);
-  init_road_speeds();
-  final_position = 30;
-  solve_1(final_position);
-  make_custom_pdf_file("example.pdf",final_position,&max_road_speed[0],solution_1_best.n_moves,&solution_1_best.positions[0],solution_1_elapsed_time,solution_1_count,"Plain recursion");
-  printf("mad road speeds:");
-  for(i = 0;i <= final_position;i++);
-  printf(" %d",max_road_speed[i]);
-  printf("\n");
-  printf("positions:");
-  for(i = 0;i <= solution_1_best.n_moves;i++)
-    printf(" %d",solution_1_best.positions[i]);
-  printf("\n");
+  if(final_position < 1 || final_position > max_road_size)
+  {
+    fprintf(stderr,"solve_bb: bad final_position\n");
+    exit(1);
+  }
+  init_pruning(state,final_position);
+  if(state->bb_stack == NULL)
+    state->bb_stack = (bb_frame_t *)alloc_memory((size_t)max_road_size + 1,sizeof(state->bb_stack[0]));
+  stack = state->bb_stack;
+  minSaltos = state->minSaltos;
+  maxVelocidade = state->maxVelocidade;
+  state->elapsed_time = thread_cpu_time();
+  state->count = 1ul; // the first node
+  state->best.n_moves = final_position + 100;
+  top = &stack[0];
+  top->position = 0;
+  top->speed = 0;
+  top->next_speed = 1;
+  top->improved = 0;
+  while(top >= stack)
+  {
+    move_number = (int)(top - stack);
+    position = top->position;
+    new_speed = top->next_speed;
+    if(new_speed < top->speed - 1 || new_speed < 1)
+    { // all speeds tried, return to the previous frame
+      if(top->improved != 0)
+      {
+        state->best.positions[move_number] = position;
+        if(top > stack)
+          top[-1].improved = 1;
+      }
+      top--;
+      continue;
+    }
+    top->next_speed--;
+    if(new_speed > _max_road_speed_ || position + new_speed > final_position || !is_legal_move(state->legal_speeds,position,new_speed))
+      continue;
+    if(state->best.n_moves <= final_position && new_speed <= maxVelocidade[position + new_speed] && move_number + 1 >= minSaltos[position + new_speed])
+      continue; // corte
+    minSaltos[position] = move_number + 1;
+    maxVelocidade[position] = top->speed;
+    for(n = 1;n < new_speed;n++)
+    {
+      minSaltos[position + n] = move_number + 1;
+      maxVelocidade[position + n] = new_speed;
+    }
+    // visit the new node
+    state->count++;
+    if(position + new_speed == final_position && new_speed == 1)
+    { // this solution is always the best
+      state->best.n_moves = move_number + 1;
+      state->best.positions[move_number + 1] = final_position;
+      top->improved = 1;
+      continue;
+    }
+    top++;
+    top->position = position + new_speed;
+    top->speed = (int8_t)new_speed;
+    top->next_speed = (int8_t)(new_speed + 1);
+    top->improved = 0;
+  }
+  state->elapsed_time = thread_cpu_time() - state->elapsed_time;
 }
 
 
+
 //
-// main program
+// bottom-up dynamic programming over the (position, speed) state graph (solve_dp mode)
+//
+//  Cada estado (posição, velocidade) só é expandido uma vez; como todos os movimentos custam 1,
+// uma pesquisa em largura a partir de (0,0) visita os estados por ordem crescente do número de
+// movimentos, logo a primeira vez que se chega a (final_position,1) é com o número mínimo de
+// movimentos. O caminho é reconstruído no fim a partir do estado anterior de cada estado.
 //
 
-int main(int argc,char *argv[argc + 1])
+#define dp_state(position,speed)  ((size_t)(position) * (1 + _max_road_speed_) + (size_t)(speed))
+
+static void solve_dp(solver_state_t *state,int final_position)
 {
-# define _time_limit_  3600.0
-  int n_mec,final_position,print_this_one;
-  char file_name[64];
+  int head,tail,position,speed,new_speed,n_moves;
+  int8_t *dp_from;
 
-  // generate the example data
-  if(argc == 2 && argv[1][0] == '-' && argv[1][1] == 'e' && argv[1][2] == 'x')
+  if(final_position < 1 || final_position > max_road_size)
   {
-    example();
-    return 0;
+    fprintf(stderr,"solve_dp: bad final_position\n");
+    exit(1);
   }
-  // initialization
-  n_mec = (argc < 2) ? 0xAED2022 : atoi(argv[1]);
-  srandom((unsigned int)n_mec);
-  init_road_speeds();
-  // run all solution methods for all interesting sizes of the problem
-  final_position = 1;
-  solution_1_elapsed_time = 0.0;
+  if(state->dp_from == NULL)
+  {
+    state->dp_from = (int8_t *)alloc_memory(dp_state(max_road_size + 1,0),sizeof(state->dp_from[0]));
+    state->dp_queue_position = (int *)alloc_memory(dp_state(max_road_size + 1,0),sizeof(state->dp_queue_position[0]));
+    state->dp_queue_speed = (int8_t *)alloc_memory(dp_state(max_road_size + 1,0),sizeof(state->dp_queue_speed[0]));
+  }
+  dp_from = state->dp_from;
+  state->elapsed_time = thread_cpu_time();
+  state->count = 0ul;
+  memset(dp_from,-1,dp_state(final_position + 1,0) * sizeof(dp_from[0]));
+  state->best.n_moves = final_position + 100;
+  // breadth-first search starting at (0,0)
+  head = tail = 0;
+  dp_from[dp_state(0,0)] = 0;
+  state->dp_queue_position[tail] = 0;
+  state->dp_queue_speed[tail++] = 0;
+  while(head < tail)
+  {
+    position = state->dp_queue_position[head];
+    speed = state->dp_queue_speed[head++];
+    state->count++;
+    if(position == final_position && speed == 1)
+      break;
+    for(new_speed = speed + 1;new_speed >= speed - 1;new_speed--)
+      if(new_speed >= 1 && new_speed <= _max_road_speed_ && position + new_speed <= final_position && dp_from[dp_state(position + new_speed,new_speed)] < 0)
+      {
+        if(is_legal_move(state->legal_speeds,position,new_speed))
+        {
+          dp_from[dp_state(position + new_speed,new_speed)] = (int8_t)speed;
+          state->dp_queue_position[tail] = position + new_speed;
+          state->dp_queue_speed[tail++] = (int8_t)new_speed;
+        }
+      }
+  }
+  // rebuild the positions from the parent links (the previous position is the current one minus the current speed)
+  if(dp_from[dp_state(final_position,1)] >= 0)
+  {
+    for(n_moves = 0,position = final_position,speed = 1;position > 0;n_moves++)
+    {
+      new_speed = dp_from[dp_state(position,speed)];
+      position -= speed;
+      speed = new_speed;
+    }
+    state->best.n_moves = n_moves;
+    for(position = final_position,speed = 1;n_moves >= 0;n_moves--)
+    {
+      state->best.positions[n_moves] = position;
+      if(position > 0)
+      {
+        new_speed = dp_from[dp_state(position,speed)];
+        position -= speed;
+        speed = new_speed;
+      }
+    }
+  }
+  state->elapsed_time = thread_cpu_time() - state->elapsed_time;
+}
 
-  printf("      ╭─────────────────────────────────╮\n");
-  printf("      │                plain recursion  │\n");
-  printf(" ╭────┼──────────┬──────────┬───────────┤\n");
-  printf(" │  n │ sol      │    count │  cpu time │\n");
-  printf(" │────┼──────────┼──────────┼───────────┤\n");
 
-  int sol = 2;
+//
+// single-pass incremental sweep over all final_positions (the dp_sweep mode)
+//
+//  As posições visitadas crescem sempre, logo o melhor caminho até (n,1) nunca passa de n e não
+// depende de final_position. Assim a tabela dos números mínimos de movimentos de cada estado é
+// calculada por ordem crescente de posição (cada estado (p,v) só depende dos estados (p-v,v-1),
+// (p-v,v) e (p-v,v+1)) e é apenas estendida, desde a última posição já calculada, quando se pede
+// um final_position maior. O esforço de cada chamada é o número de estados novos calculados.
+//  Só as últimas _sweep_window_ posições do número de movimentos são guardadas (as dependências
+// nunca recuam mais do que _max_road_speed_ posições); para a reconstrução basta a velocidade
+// anterior de cada estado, guardada num byte. Se final_position diminuir (nova estrada, ou uma
+// tarefa roubada no varrimento paralelo) a tabela é recalculada desde o início.
+//
 
-  while(final_position <= _max_road_size_/* && final_position <= 20*/)
-  {
-    print_this_one = (final_position == 10 || final_position == 20 || final_position == 50 || final_position == 100 || final_position == 200 || final_position == 400 || final_position == 800) ? 1 : 0;
-    printf(" │%3d │",final_position);
-    // first solution method (very bad)
+#define sweep_state(position,speed)  ((size_t)((position) & (_sweep_window_ - 1)) * (1 + _max_road_speed_) + (size_t)(speed))
 
-    
+static void reset_sweep(solver_state_t *state)
+{ // forget the data of the incremental solvers (a new road)
+  state->sweep_last_position = -1;
+  state->bits_depth = -1;
+}
 
+static void solve_sweep(solver_state_t *state,int final_position)
+{
+  int position,speed,old_speed,old_position,best,n_moves;
+  int *sweep_moves;
 
-    if(sol == 1) {
-        if(solution_1_elapsed_time < _time_limit_)
-        {
-        solve_1(final_position);
-        if(print_this_one != 0)
-        {
-            sprintf(file_name,"%03d_1.pdf",final_position);
-            make_custom_pdf_file(file_name,final_position,&max_road_speed[0],solution_1_best.n_moves,&solution_1_best.positions[0],solution_1_elapsed_time,solution_1_count,"Plain recursion");
-        }
-        printf(" %3d %16lu %9.3e │",solution_1_best.n_moves,solution_1_count,solution_1_elapsed_time);
-        }
-        else
+  if(final_position < 1 || final_position > max_road_size)
+  {
+    fprintf(stderr,"solve_sweep: bad final_position\n");
+    exit(1);
+  }
+  if(state->sweep_from == NULL)
+    state->sweep_from = (int8_t *)alloc_memory(dp_state(max_road_size + 1,0),sizeof(state->sweep_from[0]));
+  sweep_moves = state->sweep_moves;
+  state->elapsed_time = thread_cpu_time();
+  state->count = 0ul;
+  // extend the table up to final_position
+  if(final_position < state->sweep_last_position)
+    reset_sweep(state); // the moves of older positions are no longer available
+  if(state->sweep_last_position < 0)
+  {
+    for(speed = 0;speed <= _max_road_speed_;speed++)
+      sweep_moves[sweep_state(0,speed)] = -1;
+    sweep_moves[sweep_state(0,0)] = 0;
+    state->sweep_last_position = 0;
+  }
+  for(position = state->sweep_last_position + 1;position <= final_position;position++)
+  {
+    sweep_moves[sweep_state(position,0)] = -1;
+    for(speed = 1;speed <= _max_road_speed_;speed++)
+    {
+      state->count++;
+      sweep_moves[sweep_state(position,speed)] = -1;
+      old_position = position - speed;
+      if(old_position < 0)
+        continue;
+      if(!is_legal_move(state->legal_speeds,old_position,speed))
+        continue;
+      best = -1;
+      for(old_speed = speed + 1;old_speed >= speed - 1;old_speed--)
+        if(old_speed >= 0 && old_speed <= _max_road_speed_ && sweep_moves[sweep_state(old_position,old_speed)] >= 0 &&
+           (best < 0 || sweep_moves[sweep_state(old_position,old_speed)] < best))
         {
-        solution_1_best.n_moves = -1;
-        printf("                                |");
+          best = sweep_moves[sweep_state(old_position,old_speed)];
+          state->sweep_from[dp_state(position,speed)] = (int8_t)old_speed;
         }
+      if(best >= 0)
+        sweep_moves[sweep_state(position,speed)] = best + 1;
+    }
+  }
+  state->sweep_last_position = final_position;
+  // rebuild the positions of the best solution ending at (final_position,1)
+  state->best.n_moves = final_position + 100;
+  n_moves = sweep_moves[sweep_state(final_position,1)];
+  if(n_moves >= 0)
+  {
+    state->best.n_moves = n_moves;
+    for(position = final_position,speed = 1;n_moves >= 0;n_moves--)
+    {
+      state->best.positions[n_moves] = position;
+      if(position > 0)
+      {
+        old_speed = state->sweep_from[dp_state(position,speed)];
+        position -= speed;
+        speed = old_speed;
+      }
     }
-    
-    if(sol == 2) {
+  }
+  state->elapsed_time = thread_cpu_time() - state->elapsed_time;
+}
 
-        if(solution_2_elapsed_time < _time_limit_)
-        {
-        solve_2(final_position);
-        if(print_this_one != 0)
-        {
-            sprintf(file_name,"%03d_1.pdf",final_position);
-            make_custom_pdf_file(file_name,final_position,&max_road_speed[0],solution_2_best.n_moves,&solution_2_best.positions[0],solution_2_elapsed_time,solution_2_count,"Plain recursion");
-        }
-        printf(" %8d │ %8lu │ %9.3e │",solution_2_best.n_moves,solution_2_count,solution_2_elapsed_time);
-        }
-        else
-        {
-        solution_2_best.n_moves = -1;
-        printf("                                 │");
-        }
+#undef sweep_state
+
+
+//
+// best-first (A*) search with an admissible estimate of the number of moves still needed
+//
+//  A estimativa h(d,v) é o número exato de movimentos necessários para andar d posições, partindo
+// da velocidade v e acabando com velocidade 1, se a estrada não tivesse limites de velocidade
+// (só _max_road_speed_). Como é a distância exata num problema relaxado (com mais movimentos
+// possíveis), é admissível e consistente, logo a primeira vez que um estado sai da fila de
+// prioridade já tem o número mínimo de movimentos. A tabela é calculada por programação dinâmica
+// para d < _astar_table_size_; para d maior a solução ótima relaxada tem um troço à velocidade
+// máxima, logo h(d + _max_road_speed_,v) = h(d,v) + 1.
+//  Em caso de empate no valor de g + h é expandido primeiro o estado com mais movimentos (mais
+// perto do fim), o que reduz muito o esforço.
+//
+
+#define _astar_table_size_  256  // must be (much) larger than 2 * _max_road_speed_ * _max_road_speed_
+#define _astar_infinity_    (1 << 28)
+
+static int astar_h[_astar_table_size_][1 + _max_road_speed_];
+static pthread_once_t astar_h_once = PTHREAD_ONCE_INIT;
+
+static void init_astar_heuristic(void)
+{
+  int d,v,w,best;
+
+  for(d = 0;d < _astar_table_size_;d++)
+    for(v = 0;v <= _max_road_speed_;v++)
+    {
+      if(d == 0)
+      {
+        astar_h[d][v] = (v == 1) ? 0 : _astar_infinity_;
+        continue;
+      }
+      best = _astar_infinity_;
+      for(w = v - 1;w <= v + 1;w++)
+        if(w >= 1 && w <= _max_road_speed_ && w <= d && astar_h[d - w][w] < best)
+          best = astar_h[d - w][w];
+      astar_h[d][v] = (best < _astar_infinity_) ? best + 1 : _astar_infinity_;
     }
+  // check the periodicity used for large distances
+  for(d = _astar_table_size_ - 2 * _max_road_speed_;d < _astar_table_size_ - _max_road_speed_;d++)
+    for(v = 0;v <= _max_road_speed_;v++)
+      if(astar_h[d + _max_road_speed_][v] != astar_h[d][v] + 1)
+      {
+        fprintf(stderr,"init_astar_heuristic: _astar_table_size_ is too small\n");
+        exit(1);
+      }
+}
 
+static int astar_heuristic(int distance,int speed)
+{
+  int k;
 
-    // done
-    printf("\n");
-    fflush(stdout);
-    // new final_position
-    if(final_position < 50)
-      final_position += 1;
-    else if(final_position < 100)
-      final_position += 5;
-    else if(final_position < 200)
-      final_position += 10;
-    else
-      final_position += 20;
+  if(distance < _astar_table_size_)
+    return astar_h[distance][speed];
+  k = (distance - _astar_table_size_) / _max_road_speed_ + 1;
+  return astar_h[distance - k * _max_road_speed_][speed] + k;
+}
+
+typedef struct
+{
+  int f;          // g + h
+  int g;          // number of moves
+  int position;
+  int speed;
+}
+astar_entry_t;
+
+#define astar_before(a,b)  ((a).f < (b).f || ((a).f == (b).f && (a).g > (b).g))
+
+static void astar_push(solver_state_t *state,size_t *heap_size,astar_entry_t e)
+{
+  astar_entry_t *heap;
+  size_t i;
+
+  if(*heap_size == state->astar_heap_max_size)
+  {
+    state->astar_heap_max_size = 1024 + 2 * state->astar_heap_max_size;
+    state->astar_heap = realloc(state->astar_heap,state->astar_heap_max_size * sizeof(astar_entry_t));
+    if(state->astar_heap == NULL)
+    {
+      fprintf(stderr,"astar_push: out of memory\n");
+      exit(1);
+    }
+  }
+  heap = (astar_entry_t *)state->astar_heap;
+  for(i = (*heap_size)++;i > 0 && astar_before(e,heap[(i - 1) / 2]);i = (i - 1) / 2)
+    heap[i] = heap[(i - 1) / 2];
+  heap[i] = e;
+}
+
+static astar_entry_t astar_pop(solver_state_t *state,size_t *heap_size)
+{
+  astar_entry_t *heap,top,last;
+  size_t i,j;
+
+  heap = (astar_entry_t *)state->astar_heap;
+  top = heap[0];
+  last = heap[--(*heap_size)];
+  for(i = 0;(j = 2 * i + 1) < *heap_size;i = j)
+  {
+    if(j + 1 < *heap_size && astar_before(heap[j + 1],heap[j]))
+      j++;
+    if(!astar_before(heap[j],last))
+      break;
+    heap[i] = heap[j];
+  }
+  heap[i] = last;
+  return top;
+}
+
+static void rebuild_solution(solution_t *solution,const int8_t *from,int position,int speed,int n_moves)
+{ // positions[0..n_moves] of a path ending at (position,speed), using the speed of the previous state of each state
+  int old_speed;
+
+  for(;n_moves >= 0;n_moves--)
+  {
+    solution->positions[n_moves] = position;
+    if(position > 0)
+    {
+      old_speed = from[dp_state(position,speed)];
+      position -= speed;
+      speed = old_speed;
+    }
+  }
+}
+
+static void solve_astar(solver_state_t *state,int final_position)
+{
+  astar_entry_t e,n;
+  size_t heap_size;
+  int new_speed,h;
+  int *g;
+
+  if(final_position < 1 || final_position > max_road_size)
+  {
+    fprintf(stderr,"solve_astar: bad final_position\n");
+    exit(1);
+  }
+  pthread_once(&astar_h_once,init_astar_heuristic);
+  if(state->astar_g == NULL)
+  {
+    state->astar_g = (int *)alloc_memory(dp_state(max_road_size + 1,0),sizeof(state->astar_g[0]));
+    state->astar_from = (int8_t *)alloc_memory(dp_state(max_road_size + 1,0),sizeof(state->astar_from[0]));
+  }
+  g = state->astar_g;
+  state->elapsed_time = thread_cpu_time();
+  state->count = 0ul;
+  memset(g,-1,dp_state(final_position + 1,0) * sizeof(g[0]));
+  state->best.n_moves = final_position + 100;
+  heap_size = 0;
+  g[dp_state(0,0)] = 0;
+  e.position = e.speed = e.g = 0;
+  e.f = astar_heuristic(final_position,0);
+  astar_push(state,&heap_size,e);
+  while(heap_size > 0)
+  {
+    e = astar_pop(state,&heap_size);
+    if(e.g != g[dp_state(e.position,e.speed)])
+      continue; // stale entry
+    state->count++;
+    if(e.position == final_position && e.speed == 1)
+    {
+      state->best.n_moves = e.g;
+      rebuild_solution(&state->best,state->astar_from,final_position,1,e.g);
+      break;
+    }
+    for(new_speed = e.speed + 1;new_speed >= e.speed - 1;new_speed--)
+      if(new_speed >= 1 && new_speed <= _max_road_speed_ && e.position + new_speed <= final_position && is_legal_move(state->legal_speeds,e.position,new_speed))
+      {
+        n.position = e.position + new_speed;
+        n.speed = new_speed;
+        n.g = e.g + 1;
+        if(g[dp_state(n.position,n.speed)] >= 0 && g[dp_state(n.position,n.speed)] <= n.g)
+          continue;
+        h = astar_heuristic(final_position - n.position,n.speed);
+        if(h >= _astar_infinity_)
+          continue; // (final_position,1) cannot be reached from here
+        g[dp_state(n.position,n.speed)] = n.g;
+        state->astar_from[dp_state(n.position,n.speed)] = (int8_t)e.speed;
+        n.f = n.g + h;
+        astar_push(state,&heap_size,n);
+      }
+  }
+  state->elapsed_time = thread_cpu_time() - state->elapsed_time;
+}
+
+#undef astar_before
+
+
+//
+// bidirectional breadth-first search, meeting a backward search from (final_position,1)
+//
+//  As duas pesquisas avançam camada a camada, expandindo sempre a que tem a fronteira mais
+// pequena. Quando um estado gerado por uma delas já foi visitado pela outra temos um caminho
+// completo; o melhor destes caminhos é ótimo assim que o seu comprimento não for maior do que a
+// soma das profundidades das duas fronteiras.
+//
+
+static void solve_bidir(solver_state_t *state,int final_position)
+{
+  int head[2],tail[2],depth[2],best,meet_position,meet_speed,side,end,position,speed,new_speed,old_position,other,i;
+  int *dist[2];
+
+  if(final_position < 1 || final_position > max_road_size)
+  {
+    fprintf(stderr,"solve_bidir: bad final_position\n");
+    exit(1);
+  }
+  for(side = 0;side < 2;side++)
+  {
+    if(state->bidir_dist[side] == NULL)
+    {
+      state->bidir_dist[side] = (int *)alloc_memory(dp_state(max_road_size + 1,0),sizeof(int));
+      state->bidir_link[side] = (int8_t *)alloc_memory(dp_state(max_road_size + 1,0),sizeof(int8_t));
+      state->bidir_queue_position[side] = (int *)alloc_memory(dp_state(max_road_size + 1,0),sizeof(int));
+      state->bidir_queue_speed[side] = (int8_t *)alloc_memory(dp_state(max_road_size + 1,0),sizeof(int8_t));
+    }
+    dist[side] = state->bidir_dist[side];
+  }
+  state->elapsed_time = thread_cpu_time();
+  state->count = 0ul;
+  state->best.n_moves = final_position + 100;
+  for(side = 0;side < 2;side++)
+  {
+    memset(dist[side],-1,dp_state(final_position + 1,0) * sizeof(int));
+    head[side] = depth[side] = 0;
+    tail[side] = 1;
+    state->bidir_queue_position[side][0] = (side == 0) ? 0 : final_position;
+    state->bidir_queue_speed[side][0] = (side == 0) ? 0 : 1;
+  }
+  dist[0][dp_state(0,0)] = 0;
+  dist[1][dp_state(final_position,1)] = 0;
+  best = _astar_infinity_;
+  meet_position = meet_speed = 0;
+  while(head[0] < tail[0] && head[1] < tail[1] && best > depth[0] + depth[1])
+  {
+    // expand one layer of the side with the smaller frontier
+    side = (tail[0] - head[0] <= tail[1] - head[1]) ? 0 : 1;
+    other = 1 - side;
+    for(end = tail[side];head[side] < end;head[side]++)
+    {
+      position = state->bidir_queue_position[side][head[side]];
+      speed = state->bidir_queue_speed[side][head[side]];
+      state->count++;
+      for(new_speed = speed + 1;new_speed >= speed - 1;new_speed--)
+      {
+        if(side == 0)
+        { // forward move (position,speed) -> (position + new_speed,new_speed)
+          if(new_speed < 1 || new_speed > _max_road_speed_ || position + new_speed > final_position || !is_legal_move(state->legal_speeds,position,new_speed))
+            continue;
+          old_position = position + new_speed;
+        }
+        else
+        { // backward move (position - speed,new_speed) -> (position,speed)
+          old_position = position - speed;
+          if(new_speed < 0 || new_speed > _max_road_speed_ || old_position < 0 || (old_position == 0) != (new_speed == 0) || !is_legal_move(state->legal_speeds,old_position,speed))
+            continue;
+        }
+        i = (int)dp_state(old_position,new_speed);
+        if(dist[side][i] >= 0)
+          continue;
+        dist[side][i] = depth[side] + 1;
+        state->bidir_link[side][i] = (int8_t)speed;
+        state->bidir_queue_position[side][tail[side]] = old_position;
+        state->bidir_queue_speed[side][tail[side]++] = (int8_t)new_speed;
+        if(dist[other][i] >= 0 && depth[side] + 1 + dist[other][i] < best)
+        {
+          best = depth[side] + 1 + dist[other][i];
+          meet_position = old_position;
+          meet_speed = new_speed;
+        }
+      }
+    }
+    depth[side]++;
+  }
+  // rebuild the positions (forward part from the previous speeds, backward part from the next speeds)
+  if(best < _astar_infinity_)
+  {
+    i = dist[0][dp_state(meet_position,meet_speed)];
+    state->best.n_moves = best;
+    rebuild_solution(&state->best,state->bidir_link[0],meet_position,meet_speed,i);
+    for(position = meet_position,speed = meet_speed;i < best;)
+    {
+      speed = state->bidir_link[1][dp_state(position,speed)];
+      position += speed;
+      state->best.positions[++i] = position;
+    }
+  }
+  state->elapsed_time = thread_cpu_time() - state->elapsed_time;
+}
+
+#undef dp_state
+
+
+//
+// bit-parallel breadth-first search (the frontier is a bitset of positions for each speed)
+//
+//  O estado (p,w) é atingido a partir de (p-w,v), v em {w-1,w,w+1}, se o movimento de p-w com
+// velocidade w for legal. Com uma máscara de bits L[w] das posições das quais esse movimento é
+// legal, a nova fronteira de velocidade w é ((F[w-1] | F[w] | F[w+1]) & L[w]) << w, menos os
+// estados já visitados: 64 posições de uma vez (256 com AVX2). A pesquisa em largura não
+// depende de final_position, logo o número mínimo de movimentos fica conhecido para todas as
+// posições finais ao mesmo tempo; cada chamada só avança a pesquisa até todas as posições da
+// fronteira serem >= final_position (e.g. no varrimento a pesquisa é feita uma única vez).
+//  Para a reconstrução, em vez da velocidade anterior de cada estado, guardam-se dois bits por
+// estado (as máscaras "up" e "down": a velocidade anterior era w+1 ou w-1).
+//
+
+enum { bits_frontier,bits_next,bits_visited,bits_up,bits_down,bits_legal,bits_n_kinds };
+
+#define bits_n_words         ((size_t)max_road_size / 64 + 2)  // one more for the bits shifted out of the last word
+#define bits_row(state,kind,speed)  (&(state)->bits[((size_t)(kind) * (1 + _max_road_speed_) + (size_t)(speed)) * (1 + bits_n_words) + 1]) // word -1 is always zero
+#define bits_shift(x,x_prev,w)  (((x) << (w)) | ((x_prev) >> (64 - (w))))
+
+static void reset_bits(solver_state_t *state)
+{
+  uint64_t *legal;
+  int position,speed;
+
+  if(state->bits == NULL)
+  {
+    state->bits = (uint64_t *)alloc_memory((size_t)bits_n_kinds * (1 + _max_road_speed_) * (1 + bits_n_words),sizeof(uint64_t));
+    state->bits_moves = (int *)alloc_memory((size_t)max_road_size + 1,sizeof(int));
+  }
+  else
+    memset(state->bits,0,(size_t)bits_n_kinds * (1 + _max_road_speed_) * (1 + bits_n_words) * sizeof(uint64_t));
+  for(position = 0;position <= max_road_size;position++)
+  {
+    state->bits_moves[position] = -1;
+    for(speed = 1;speed <= _max_road_speed_;speed++)
+      if(is_legal_move(state->legal_speeds,position,speed))
+      {
+        legal = bits_row(state,bits_legal,speed);
+        legal[position / 64] |= (uint64_t)1 << (position % 64);
+      }
+  }
+  // the first move, (0,0) -> (1,1), is done by hand (speed 0 is not stored in the bitsets)
+  state->bits_depth = 1;
+  state->bits_first_word = state->bits_last_word = 0;
+  if(is_legal_move(state->legal_speeds,0,1))
+  {
+    bits_row(state,bits_frontier,1)[0] = bits_row(state,bits_visited,1)[0] = (uint64_t)1 << 1;
+    state->bits_moves[1] = 1;
+  }
+  else
+    state->bits_last_word = -1; // empty frontier
+}
+
+static void bits_layer(solver_state_t *state,int speed,int first_word,int last_word)
+{ // compute the next frontier of one speed in words first_word..last_word
+  const uint64_t *legal,*f_down,*f_same,*f_up;
+  uint64_t *next,*visited,*up,*down,a_down,a_same,a_up,l,l_prev,new;
+  int i;
+
+  legal = bits_row(state,bits_legal,speed);
+  f_down = bits_row(state,bits_frontier,speed - 1); // speed 0 is always empty
+  f_same = bits_row(state,bits_frontier,speed);
+  f_up = bits_row(state,bits_frontier,(speed < _max_road_speed_) ? speed + 1 : 0);
+  next = bits_row(state,bits_next,speed);
+  visited = bits_row(state,bits_visited,speed);
+  up = bits_row(state,bits_up,speed);
+  down = bits_row(state,bits_down,speed);
+  i = first_word;
+#ifdef __AVX2__
+  {
+    __m256i va_down,va_same,va_up,vl,vl_prev,vnew;
+    __m128i left = _mm_cvtsi32_si128(speed),right = _mm_cvtsi32_si128(64 - speed);
+
+#   define bits_shift_avx2(x,x_prev)  _mm256_or_si256(_mm256_sll_epi64((x),left),_mm256_srl_epi64((x_prev),right))
+#   define bits_load(p)               _mm256_loadu_si256((const __m256i *)(p))
+    for(;i + 3 <= last_word;i += 4)
+    {
+      vl = bits_load(&legal[i]);
+      vl_prev = bits_load(&legal[i - 1]);
+      va_down = bits_shift_avx2(_mm256_and_si256(bits_load(&f_down[i]),vl),_mm256_and_si256(bits_load(&f_down[i - 1]),vl_prev));
+      va_same = bits_shift_avx2(_mm256_and_si256(bits_load(&f_same[i]),vl),_mm256_and_si256(bits_load(&f_same[i - 1]),vl_prev));
+      va_up = bits_shift_avx2(_mm256_and_si256(bits_load(&f_up[i]),vl),_mm256_and_si256(bits_load(&f_up[i - 1]),vl_prev));
+      vnew = _mm256_andnot_si256(bits_load(&visited[i]),_mm256_or_si256(_mm256_or_si256(va_down,va_same),va_up));
+      _mm256_storeu_si256((__m256i *)&next[i],vnew);
+      _mm256_storeu_si256((__m256i *)&visited[i],_mm256_or_si256(bits_load(&visited[i]),vnew));
+      _mm256_storeu_si256((__m256i *)&up[i],_mm256_or_si256(bits_load(&up[i]),_mm256_and_si256(va_up,vnew)));
+      _mm256_storeu_si256((__m256i *)&down[i],_mm256_or_si256(bits_load(&down[i]),_mm256_andnot_si256(va_up,_mm256_and_si256(va_down,vnew))));
+    }
+#   undef bits_shift_avx2
+#   undef bits_load
+  }
+#endif
+  for(;i <= last_word;i++)
+  {
+    l = legal[i];
+    l_prev = legal[i - 1];
+    a_down = bits_shift(f_down[i] & l,f_down[i - 1] & l_prev,speed);
+    a_same = bits_shift(f_same[i] & l,f_same[i - 1] & l_prev,speed);
+    a_up = (speed < _max_road_speed_) ? bits_shift(f_up[i] & l,f_up[i - 1] & l_prev,speed) : 0;
+    new = (a_down | a_same | a_up) & ~visited[i];
+    next[i] = new;
+    visited[i] |= new;
+    up[i] |= a_up & new;
+    down[i] |= a_down & new & ~a_up;
+  }
+}
+
+static void solve_bits(solver_state_t *state,int final_position)
+{
+  uint64_t *frontier,*next,word,any;
+  int i,position,speed,old_speed,first_word,last_word,n_moves;
+
+  if(final_position < 1 || final_position > max_road_size)
+  {
+    fprintf(stderr,"solve_bits: bad final_position\n");
+    exit(1);
+  }
+  if(state->bits == NULL || state->bits_depth < 0)
+    reset_bits(state); // O(max_road_size), not timed (like the allocations of the other solvers)
+  state->elapsed_time = thread_cpu_time();
+  state->count = 0ul;
+  // advance the search until (final_position,1) is reached or cannot be reached anymore
+  while(state->bits_moves[final_position] < 0 && state->bits_last_word >= state->bits_first_word)
+  {
+    first_word = state->bits_first_word;
+    last_word = state->bits_last_word;
+    for(any = 0,speed = 1;speed <= _max_road_speed_;speed++)
+      any |= bits_row(state,bits_frontier,speed)[first_word];
+    if(64 * first_word + __builtin_ctzll(any) >= final_position)
+      break; // all moves end beyond final_position
+    if(last_word + 1 < (int)bits_n_words)
+      last_word++;
+    for(speed = 1;speed <= _max_road_speed_;speed++)
+      bits_layer(state,speed,first_word,last_word);
+    // the next frontier becomes the frontier (the old frontier, now cleared, is used for the next one)
+    state->bits_first_word = last_word + 1;
+    state->bits_last_word = -1;
+    for(speed = 1;speed <= _max_road_speed_;speed++)
+    {
+      frontier = bits_row(state,bits_frontier,speed);
+      next = bits_row(state,bits_next,speed);
+      for(i = first_word;i <= last_word;i++)
+      {
+        state->count += (unsigned long)__builtin_popcountll(frontier[i]);
+        frontier[i] = next[i];
+        next[i] = 0;
+        if(frontier[i] != 0)
+        {
+          if(i < state->bits_first_word)
+            state->bits_first_word = i;
+          if(i > state->bits_last_word)
+            state->bits_last_word = i;
+        }
+      }
+    }
+    state->bits_depth++;
+    // record the new (position,1) states
+    frontier = bits_row(state,bits_frontier,1);
+    for(i = first_word;i <= last_word;i++)
+      for(word = frontier[i];word != 0;word &= word - 1)
+        state->bits_moves[64 * i + __builtin_ctzll(word)] = state->bits_depth;
+  }
+  // rebuild the positions of the best solution ending at (final_position,1)
+  state->best.n_moves = final_position + 100;
+  n_moves = state->bits_moves[final_position];
+  if(n_moves >= 0)
+  {
+    state->best.n_moves = n_moves;
+    for(position = final_position,speed = 1;n_moves >= 0;n_moves--)
+    {
+      state->best.positions[n_moves] = position;
+      if(position > 0)
+      {
+        old_speed = speed;
+        if((bits_row(state,bits_up,speed)[position / 64] >> (position % 64)) & 1)
+          old_speed++;
+        else if((bits_row(state,bits_down,speed)[position / 64] >> (position % 64)) & 1)
+          old_speed--;
+        position -= speed;
+        speed = old_speed;
+      }
+    }
+  }
+  state->elapsed_time = thread_cpu_time() - state->elapsed_time;
+}
+
+#undef bits_n_words
+#undef bits_row
+#undef bits_shift
+
+
+//
+// greedy macro-move solver over the run-length encoded road (solve_rle mode)
+//
+//  Em cada movimento tenta-se acelerar, depois manter e por fim travar, aceitando a primeira
+// velocidade legal a partir da qual ainda é possível travar a fundo (v-1, v-2, ..., 1) sem passar
+// um limite de velocidade nem final_position (rle_can_stop()); travar a fundo é sempre possível a
+// partir do estado atual, logo há sempre uma escolha. Dentro de um segmento de limite constante L,
+// enquanto a travagem a fundo não sair do segmento a escolha é conhecida sem olhar para a estrada:
+// acelera-se até L e depois anda-se a L durante (fim - p - L(L-1)/2) / L movimentos de uma vez.
+// Só perto do fim de cada segmento se examinam os movimentos um a um, logo o número de decisões
+// (count) é proporcional ao número de segmentos e não ao tamanho da estrada (mas as posições da
+// solução continuam a ser escritas uma a uma). O número de movimentos é o mesmo que o dos
+// solvers exatos (confirmado contra o dp).
+//
+
+static int rle_can_stop(const uint16_t *legal_speeds,int position,int speed,int final_position)
+{ // is braking as hard as possible from (position,speed) legal?
+  while(speed > 1)
+  {
+    speed--;
+    if(position + speed > final_position || !is_legal_move(legal_speeds,position,speed))
+      return 0;
+    position += speed;
+  }
+  return 1;
+}
+
+static void solve_rle(solver_state_t *state,int final_position)
+{
+  const road_t *r = state->road;
+  int *positions,position,speed,n_moves,segment,limit,end,k,new_speed;
+
+  if(final_position < 1 || final_position > max_road_size)
+  {
+    fprintf(stderr,"solve_rle: bad final_position\n");
+    exit(1);
+  }
+  state->elapsed_time = thread_cpu_time();
+  state->count = 0ul;
+  positions = state->best.positions;
+  positions[0] = position = speed = n_moves = segment = 0;
+  while(position < final_position)
+  {
+    state->count++;
+    while(r->segment_start[segment + 1] <= position)
+      segment++;
+    limit = r->max_road_speed[position];
+    end = r->segment_start[segment + 1] - 1;
+    if(end > final_position)
+      end = final_position;
+    if(speed < limit && position + (speed + 1) + (speed + 1) * speed / 2 <= end)
+    { // accelerate (the windows of the move and of the hard braking after it are inside the segment)
+      do
+      {
+        speed++;
+        positions[++n_moves] = (position += speed);
+      }
+      while(speed < limit && position + (speed + 1) + (speed + 1) * speed / 2 <= end);
+      continue;
+    }
+    if(speed == limit && (k = (end - speed * (speed - 1) / 2 - position) / speed) >= 1)
+    { // cruise (accelerating is not legal, braking after each move stays inside the segment)
+      for(;k > 0;k--)
+        positions[++n_moves] = (position += speed);
+      continue;
+    }
+    // near the end of the segment: one move at a time
+    for(new_speed = speed + 1;new_speed >= speed - 1 && new_speed >= 1;new_speed--)
+      if(new_speed <= _max_road_speed_ && position + new_speed <= final_position && is_legal_move(state->legal_speeds,position,new_speed) &&
+         rle_can_stop(state->legal_speeds,position + new_speed,new_speed,final_position) != 0)
+        break;
+    if(new_speed < speed - 1 || new_speed < 1)
+    {
+      fprintf(stderr,"solve_rle: no legal move at position %d\n",position);
+      exit(1);
+    }
+    speed = new_speed;
+    positions[++n_moves] = (position += speed);
+  }
+  state->best.n_moves = n_moves;
+  state->elapsed_time = thread_cpu_time() - state->elapsed_time;
+}
+
+
+//
+// the solution methods
+//
+
+typedef struct
+{
+  char *name;                                        // name used in the -s option
+  char *title;                                       // title used in the table and in the PDF files
+  char *pdf_suffix;                                  // the PDF files are named %03d_<pdf_suffix>.pdf
+  void (*solve)(solver_state_t *state,int final_position);
+}
+solver_t;
+
+static solver_t solvers[] =
+{
+  { "1"    ,"Plain recursion"    ,"1"    ,solve_1     },
+  { "2"    ,"Pruned recursion"   ,"1"    ,solve_2     },
+  { "bb"   ,"Branch and bound"   ,"bb"   ,solve_bb    },
+  { "dp"   ,"Dynamic programming","dp"   ,solve_dp    },
+  { "sweep","Incremental sweep"  ,"sweep",solve_sweep },
+  { "astar","A* search"          ,"astar",solve_astar },
+  { "bidir","Bidirectional BFS"  ,"bidir",solve_bidir },
+  { "bits" ,"Bit-parallel BFS"   ,"bits" ,solve_bits  },
+  { "rle"  ,"Greedy macro-moves" ,"rle"  ,solve_rle   }
+};
+#define n_solvers  (int)(sizeof(solvers) / sizeof(solvers[0]))
+
+
+//
+// example of the slides
+//
+
+static void example(void)
+{
+  solver_state_t state;
+  int i,final_position;
+
+  init_road_speeds(&road,0xAED2022);
+  init_solver_state(&state,&road);
+  final_position = 30;
+  solve_1(&state,final_position);
+  make_custom_pdf_file("example.pdf",final_position,&road.max_road_speed[0],state.best.n_moves,&state.best.positions[0],state.elapsed_time,state.count,"Plain recursion");
+  printf("mad road speeds:");
+  for(i = 0;i <= final_position;i++);
+  printf(" %d",road.max_road_speed[i]);
+  printf("\n");
+  printf("positions:");
+  for(i = 0;i <= state.best.n_moves;i++)
+    printf(" %d",state.best.positions[i]);
+  printf("\n");
+  free_solver_state(&state);
+}
+
+
+//
+// the step schedule of the final_position sweep
+//
+//  Uma lista separada por vírgulas de "limite:passo"; o passo é usado enquanto final_position for
+// menor do que o limite, e a última entrada pode não ter limite. Um passo da forma "xF" multiplica
+// final_position por F (útil para estradas muito grandes). O valor por omissão reproduz a
+// sequência 1..50 (de 1 em 1), ..100 (de 5 em 5), ..200 (de 10 em 10), ... (de 20 em 20).
+//
+
+#define _max_schedule_entries_  16
+
+static int n_schedule_entries;
+static int schedule_limit[_max_schedule_entries_];  // the step is used while final_position < limit
+static int schedule_step[_max_schedule_entries_];   // the step (a multiplication factor if schedule_factor is set)
+static int schedule_factor[_max_schedule_entries_];
+
+static int parse_schedule(const char *schedule)
+{
+  char *end;
+  long v;
+
+  n_schedule_entries = 0;
+  while(*schedule != '\0')
+  {
+    if(n_schedule_entries == _max_schedule_entries_)
+      return -1;
+    schedule_limit[n_schedule_entries] = INT32_MAX;
+    v = strtol(schedule,&end,10);
+    if(end != schedule && *end == ':')
+    {
+      schedule_limit[n_schedule_entries] = (int)v;
+      schedule = end + 1;
+    }
+    schedule_factor[n_schedule_entries] = (*schedule == 'x') ? 1 : 0;
+    if(*schedule == 'x')
+      schedule++;
+    v = strtol(schedule,&end,10);
+    if(end == schedule || v < 1 || (schedule_factor[n_schedule_entries] != 0 && v < 2) || (*end != ',' && *end != '\0'))
+      return -1;
+    schedule_step[n_schedule_entries++] = (int)v;
+    schedule = (*end == ',') ? end + 1 : end;
+  }
+  return (n_schedule_entries > 0) ? 0 : -1;
+}
+
+static int next_final_position(int final_position)
+{
+  int i;
+  long next;
+
+  for(i = 0;i < n_schedule_entries - 1 && final_position >= schedule_limit[i];i++)
+    ;
+  next = (schedule_factor[i] != 0) ? (long)final_position * schedule_step[i] : (long)final_position + schedule_step[i];
+  return (next > INT32_MAX) ? INT32_MAX : (int)next;
+}
+
+
+//
+// asynchronous PDF rendering
+//
+//  Os ficheiros PDF são feitos por threads de fundo (-w, uma por omissão), para não atrasar o
+// varrimento: cada pedido leva uma cópia de tudo o que é preciso (velocidades máximas da estrada,
+// posições da solução, tempo e esforço), pelo que o solver pode continuar de imediato. A fila é
+// esvaziada (e as threads terminadas) à saída do programa. Com -w 0 os PDF são feitos logo.
+//
+//  Com --report, em vez de um ficheiro por solução, é feito um único PDF com uma página por
+// (solver, tamanho), pela ordem em que os pedidos foram feitos. O relatório é fechado à saída,
+// depois de a fila ter sido esvaziada.
+//
+
+#define _max_pdf_threads_  8
+
+typedef struct pdf_job_s
+{
+  struct pdf_job_s *next;
+  char file_name[64];
+  int page_number;          // the page of the report (-1 when a file is made)
+  int road_size;
+  uint8_t *max_road_speed;  // a copy (positions 0..road_size)
+  int n_moves;
+  int *positions;           // owned by the job
+  double elapsed_time;
+  unsigned long effort;
+  char *title;              // a string constant
+}
+pdf_job_t;
+
+static int n_pdf_threads = 1;
+static int pdf_threads_running;
+static pthread_t pdf_threads[_max_pdf_threads_];
+static pdf_job_t *pdf_queue_head,*pdf_queue_tail;
+static int pdf_queue_closed;
+static pthread_mutex_t pdf_queue_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t pdf_queue_not_empty = PTHREAD_COND_INITIALIZER;
+static pdf_report_t *pdf_report;
+static int n_pdf_report_pages;
+
+static void render_pdf_job(pdf_job_t *job)
+{
+  trace_begin("pdf",job->road_size);
+  if(job->page_number >= 0)
+    add_pdf_report_page(pdf_report,job->page_number,job->road_size,job->max_road_speed,job->n_moves,job->positions,job->elapsed_time,job->effort,job->title);
+  else
+    make_custom_pdf_file(job->file_name,job->road_size,job->max_road_speed,job->n_moves,job->positions,job->elapsed_time,job->effort,job->title);
+  trace_end("pdf",job->road_size);
+  free(job->max_road_speed);
+  free(job->positions);
+  free(job);
+}
+
+static void *pdf_worker(void *arg)
+{
+  pdf_job_t *job;
+
+  (void)arg;
+  for(;;)
+  {
+    pthread_mutex_lock(&pdf_queue_lock);
+    while(pdf_queue_head == NULL && pdf_queue_closed == 0)
+      pthread_cond_wait(&pdf_queue_not_empty,&pdf_queue_lock);
+    job = pdf_queue_head;
+    if(job != NULL && (pdf_queue_head = job->next) == NULL)
+      pdf_queue_tail = NULL;
+    pthread_mutex_unlock(&pdf_queue_lock);
+    if(job == NULL)
+      return NULL; // closed and empty
+    render_pdf_job(job);
+  }
+}
+
+static void flush_pdf_queue(void)
+{ // called at exit
+  int i;
+
+  pthread_mutex_lock(&pdf_queue_lock);
+  pdf_queue_closed = 1;
+  pthread_cond_broadcast(&pdf_queue_not_empty);
+  pthread_mutex_unlock(&pdf_queue_lock);
+  for(i = 0;i < pdf_threads_running;i++)
+    pthread_join(pdf_threads[i],NULL);
+  pdf_threads_running = 0;
+}
+
+static void queue_pdf(const char *file_name,int road_size,const uint8_t *max_road_speed,int n_moves,int **positions,double elapsed_time,unsigned long effort,char *title)
+{ // takes ownership of *positions (it must have been allocated by alloc_memory())
+  pdf_job_t *job;
+
+  job = (pdf_job_t *)alloc_memory(1,sizeof(pdf_job_t));
+  snprintf(job->file_name,sizeof(job->file_name),"%s",file_name);
+  job->page_number = (pdf_report != NULL) ? n_pdf_report_pages++ : -1;
+  job->road_size = road_size;
+  job->max_road_speed = (uint8_t *)alloc_memory((size_t)road_size + 1,sizeof(uint8_t));
+  memcpy(job->max_road_speed,max_road_speed,(size_t)road_size + 1);
+  job->n_moves = n_moves;
+  job->positions = *positions;
+  *positions = NULL;
+  job->elapsed_time = elapsed_time;
+  job->effort = effort;
+  job->title = title;
+  if(n_pdf_threads <= 0)
+  { // synchronous
+    render_pdf_job(job);
+    return;
+  }
+  pthread_mutex_lock(&pdf_queue_lock);
+  if(pdf_threads_running == 0)
+  { // first job, start the workers
+    for(;pdf_threads_running < n_pdf_threads;pdf_threads_running++)
+      if(pthread_create(&pdf_threads[pdf_threads_running],NULL,pdf_worker,NULL) != 0)
+      {
+        fprintf(stderr,"queue_pdf: unable to create thread\n");
+        exit(1);
+      }
+    atexit(flush_pdf_queue);
+  }
+  if(pdf_queue_tail == NULL)
+    pdf_queue_head = job;
+  else
+    pdf_queue_tail->next = job;
+  pdf_queue_tail = job;
+  pthread_cond_signal(&pdf_queue_not_empty);
+  pthread_mutex_unlock(&pdf_queue_lock);
+}
+
+static void close_report(void)
+{ // called at exit (after flush_pdf_queue(), because it was registered before it)
+  close_pdf_report(pdf_report);
+  pdf_report = NULL;
+}
+
+static void open_report(const char *file_name)
+{
+  pdf_report = open_pdf_report((char *)file_name);
+  atexit(close_report);
+}
+
+
+//
+// the sweep over all final_positions
+//
+//  Cada final_position do varrimento é uma tarefa independente. No modo paralelo (-j N) as
+// tarefas são distribuídas alternadamente pelas filas de N threads; cada thread tira tarefas do
+// início da sua fila (as mais pequenas, logo as linhas da tabela ficam prontas cedo) e, quando a
+// sua fila fica vazia, rouba a tarefa do fim da fila de outra thread (a maior, logo a mais cara).
+// Como o custo cresce muito com final_position, uma divisão estática deixaria threads paradas.
+// As linhas da tabela e os ficheiros PDF são produzidos pela thread principal, por ordem.
+//  O modo batch (-b) usa as mesmas tarefas, mas com uma estrada (um n_mec) por tarefa.
+//  Antes de cada tarefa o custo é previsto a partir das últimas final_positions já resolvidas
+// (ver predict_solve_time()); se a previsão passar o tempo que resta (o limite por tarefa ou o
+// que sobra do orçamento total dado com -t) a tarefa, e as maiores, não são resolvidas.
+//
+
+#define _time_limit_     3600.0  // the maximum time of one solve
+#define _growth_points_       6  // the number of previous final positions used to predict the cost of the next one
+
+typedef struct
+{
+  road_t *road;            // the road to solve
+  int final_position;
+  int print_this_one;
+  int done;                // the result is ready
+  int skipped;             // not solved: 1 when a smaller final_position exceeded the time limit, 2 when its predicted time was too large
+  double predicted_time;   // the predicted solve time (-1.0 when there were not enough data to predict it)
+  int n_moves;
+  unsigned long count;
+  double elapsed_time;
+  profile_t profile;       // wall time and hardware counters of the solve
+  int *positions;          // a copy of the solution (only when print_this_one is set, or when there is a solution log)
+}
+sweep_task_t;
+
+typedef struct
+{
+  pthread_mutex_t lock;
+  int *tasks;              // indices into sweep_tasks[]
+  int head;                // the owner takes tasks from here
+  int tail;                // thieves take tasks from here (one past the last task)
+}
+task_deque_t;
+
+static solver_t *sweep_solver;
+static sweep_task_t *sweep_tasks;
+static int n_sweep_tasks;
+static task_deque_t task_deques[_max_threads_];
+static int n_threads;
+static pthread_mutex_t sweep_lock = PTHREAD_MUTEX_INITIALIZER; // protects the done flags and limit_position
+static pthread_cond_t sweep_task_done = PTHREAD_COND_INITIALIZER;
+static int limit_position = INT32_MAX;                         // tasks with a larger final_position are skipped
+static double time_budget;                                     // total solve time budget of the sweep (-t option, 0.0 means no budget)
+static double time_used;                                       // solve time of the tasks already done
+static FILE *solution_log;                                     // the binary solution log (-l option, NULL means none)
+static int show_profile;                                       // add the wall time and the hardware counters to the table (-p option)
+
+static int take_task(int thread_number)
+{
+  task_deque_t *d;
+  int i,task;
+
+  // first try our own deque
+  d = &task_deques[thread_number];
+  pthread_mutex_lock(&d->lock);
+  task = (d->head < d->tail) ? d->tasks[d->head++] : -1;
+  pthread_mutex_unlock(&d->lock);
+  // then try to steal from the others
+  for(i = 1;task < 0 && i < n_threads;i++)
+  {
+    d = &task_deques[(thread_number + i) % n_threads];
+    pthread_mutex_lock(&d->lock);
+    task = (d->head < d->tail) ? d->tasks[--d->tail] : -1;
+    pthread_mutex_unlock(&d->lock);
+  }
+  return task;
+}
+
+static double predict_solve_time(sweep_task_t *task)
+{ // fits the effort of the last solved smaller final positions (call it with sweep_lock locked)
+  double x[_growth_points_],y[_growth_points_],sum_time,sum_count,x_mean,y_mean,sxx,sxy,a,b,e,sse,best_sse,prediction;
+  int i,j,n,model;
+
+  // the data: log(count) as a function of final_position
+  sum_time = sum_count = 0.0;
+  for(n = 0,i = (int)(task - sweep_tasks) - 1;i >= 0 && n < _growth_points_;i--)
+    if(sweep_tasks[i].done != 0 && sweep_tasks[i].skipped == 0 && sweep_tasks[i].count > 0ul && sweep_tasks[i].final_position < task->final_position)
+    {
+      x[n] = (double)sweep_tasks[i].final_position;
+      y[n] = log((double)sweep_tasks[i].count);
+      sum_time += sweep_tasks[i].elapsed_time;
+      sum_count += (double)sweep_tasks[i].count;
+      n++;
+    }
+  if(n < 3)
+    return -1.0;
+  // two models, exponential (log(count) linear in n) and power law (log(count) linear in log(n)); keep the best fit
+  prediction = -1.0;
+  best_sse = 0.0;
+  for(model = 0;model < 2;model++)
+  {
+    x_mean = y_mean = 0.0;
+    for(j = 0;j < n;j++)
+    {
+      x_mean += (model == 0) ? x[j] : log(x[j]);
+      y_mean += y[j];
+    }
+    x_mean /= (double)n;
+    y_mean /= (double)n;
+    sxx = sxy = 0.0;
+    for(j = 0;j < n;j++)
+    {
+      e = ((model == 0) ? x[j] : log(x[j])) - x_mean;
+      sxx += e * e;
+      sxy += e * (y[j] - y_mean);
+    }
+    if(sxx <= 0.0)
+      continue;
+    b = sxy / sxx;
+    a = y_mean - b * x_mean;
+    for(sse = 0.0,j = 0;j < n;j++)
+    {
+      e = y[j] - (a + b * ((model == 0) ? x[j] : log(x[j])));
+      sse += e * e;
+    }
+    if(prediction < 0.0 || sse < best_sse)
+    {
+      best_sse = sse;
+      prediction = exp(a + b * ((model == 0) ? (double)task->final_position : log((double)task->final_position)));
+    }
+  }
+  // the time per unit of effort of the same solves
+  return (prediction < 0.0) ? -1.0 : prediction * (sum_time / sum_count);
+}
+
+static void run_task(solver_state_t *state,sweep_task_t *task)
+{
+  double remaining;
+  int skip;
+
+  pthread_mutex_lock(&sweep_lock);
+  skip = (task->final_position > limit_position) ? 1 : 0;
+  task->predicted_time = predict_solve_time(task);
+  remaining = _time_limit_;
+  if(time_budget > 0.0 && time_budget - time_used < remaining)
+    remaining = time_budget - time_used;
+  if(skip == 0 && (remaining <= 0.0 || task->predicted_time > remaining))
+  { // it would take too long (so would the larger ones)
+    skip = 2;
+    if(task->final_position - 1 < limit_position)
+      limit_position = task->final_position - 1;
+  }
+  pthread_mutex_unlock(&sweep_lock);
+  if(skip == 0)
+  {
+    if(state->legal_speeds != task->road->legal_speeds)
+    { // a different road
+      state->legal_speeds = task->road->legal_speeds;
+      state->road = task->road;
+      reset_sweep(state);
+    }
+    memset(&task->profile,0,sizeof(task->profile));
+    trace_begin("solve",task->final_position);
+    profile_region(&task->profile)
+    {
+      (*sweep_solver->solve)(state,task->final_position);
+    }
+    trace_end("solve",task->final_position);
+    trace_counter("effort",state->count);
+    task->n_moves = state->best.n_moves;
+    task->count = state->count;
+    task->elapsed_time = state->elapsed_time;
+    if(task->print_this_one != 0 || solution_log != NULL)
+    {
+      task->positions = (int *)alloc_memory((size_t)task->n_moves + 1,sizeof(task->positions[0]));
+      memcpy(task->positions,state->best.positions,((size_t)task->n_moves + 1) * sizeof(task->positions[0]));
+    }
+  }
+  pthread_mutex_lock(&sweep_lock);
+  task->skipped = skip;
+  if(skip == 0)
+    time_used += task->elapsed_time;
+  if(skip == 0 && task->elapsed_time >= _time_limit_ && task->final_position < limit_position)
+    limit_position = task->final_position;
+  task->done = 1;
+  pthread_cond_broadcast(&sweep_task_done);
+  pthread_mutex_unlock(&sweep_lock);
+}
+
+static void *sweep_worker(void *arg)
+{
+  solver_state_t state;
+  int task;
+
+  init_solver_state(&state,sweep_tasks[0].road);
+  while((task = take_task((int)(intptr_t)arg)) >= 0)
+    run_task(&state,&sweep_tasks[task]);
+  free_solver_state(&state);
+  close_counters();
+  return NULL;
+}
+
+
+//
+// multi-process sweep (-m option)
+//
+//  Em vez de threads, n_processes processos filhos (criados com fork(), por isso já têm as
+// estradas e as tarefas) resolvem as tarefas de sweep_tasks[]. Cada tarefa é um job (seed,
+// final_position) de uma fila em memória partilhada; os processos tiram os jobs pela ordem da
+// fila, protegida por um semáforo, e escrevem o resultado (e, quando é preciso, a solução) na
+// mesma memória partilhada. O processo pai imprime os resultados por ordem, esperando por eles no
+// semáforo dos resultados. As soluções passam por um anel de _process_window_ * n_processes
+// lugares (o job i usa o lugar i % window), por isso um processo só tira o job i depois de o pai
+// ter consumido o job i - window (o job mais antigo ainda não consumido pode sempre avançar, logo
+// não há deadlock). Só é usado o limite de tempo de cada tarefa (_time_limit_), não a previsão
+// do tempo das tarefas seguintes (nem o orçamento da opção -t).
+//
+
+static int n_processes;    // 0 means threads (or sequential)
+
+#if _use_processes_ > 0
+
+#include <signal.h>
+#include <sys/ipc.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#ifdef __linux__
+# include <sys/prctl.h>
+#endif
+#include "../../../SO/JantarDeAmigos/src/semaphore.h"
+#include "../../../SO/JantarDeAmigos/src/sharedMemory.h"
+
+#define _process_mutex_    1  // the semaphore that protects the shared data (1 .. snum)
+#define _process_results_  2  // the semaphore that is upped once for each job done
+#define _process_slots_    3  // the semaphore that is upped once for each process waiting for a free slot of the ring
+#define _process_window_   4  // the ring of solutions has _process_window_ * n_processes slots
+
+typedef struct
+{
+  int seed;
+  int final_position;
+  int state;               // 0: waiting, 1: being solved, 2: done
+  int skipped;
+  int n_moves;
+  unsigned long count;
+  double elapsed_time;
+  profile_t profile;
+  long positions_offset;   // where the positions of the solution go, in its slot of the ring (-1 when they are not needed)
+}
+process_job_t;
+
+typedef struct
+{
+  int n_jobs;
+  int next_job;            // the next job of the queue
+  int limit_position;      // jobs with a larger final_position are skipped
+  int window;              // the number of slots of the ring of solutions
+  int n_consumed;          // jobs 0..n_consumed-1 were consumed by the parent (their slots are free)
+  int n_waiting;           // the number of processes waiting for a free slot
+  process_job_t jobs[];    // followed by the ring of solutions (window slots, each one large enough for the largest final_position)
+}
+process_shared_t;
+
+static int process_semgid = -1;  // the semaphore set (it must be destroyed explicitly, even if the sweep is interrupted)
+
+static void process_interrupted(int signal_number)
+{
+  if(process_semgid >= 0)
+    (void)semDestroy(process_semgid);
+  _exit(128 + signal_number);
+}
+
+static void process_sem(int semgid,int up,unsigned int sindex)
+{
+  if(((up != 0) ? semUp(semgid,sindex) : semDown(semgid,sindex)) != 0)
+  {
+    perror("process_sem");
+    exit(1);
+  }
+}
+
+static void process_worker(process_shared_t *sh,int semgid,int *positions)
+{
+  solver_state_t state;
+  process_job_t *job;
+  int i,skip;
+
+#ifdef __linux__
+  (void)prctl(PR_SET_PDEATHSIG,SIGKILL); // do not outlive the parent
+#endif
+  signal(SIGINT,SIG_DFL);
+  signal(SIGTERM,SIG_DFL);
+  close_counters(); // the counters inherited from the parent (if any) measure the parent
+  init_solver_state(&state,sweep_tasks[0].road);
+  for(;;)
+  {
+    // claim a job (when its slot of the ring is free)
+    process_sem(semgid,0,_process_mutex_);
+    while(sh->next_job < sh->n_jobs && sh->next_job >= sh->n_consumed + sh->window)
+    {
+      sh->n_waiting++;
+      process_sem(semgid,1,_process_mutex_);
+      process_sem(semgid,0,_process_slots_);
+      process_sem(semgid,0,_process_mutex_);
+    }
+    i = (sh->next_job < sh->n_jobs) ? sh->next_job++ : -1;
+    if(i >= 0)
+    {
+      sh->jobs[i].state = 1;
+      skip = (sh->jobs[i].final_position > sh->limit_position) ? 1 : 0;
+    }
+    process_sem(semgid,1,_process_mutex_);
+    if(i < 0)
+      break;
+    // solve it
+    job = &sh->jobs[i];
+    if(skip == 0)
+    {
+      if(state.legal_speeds != sweep_tasks[i].road->legal_speeds)
+      { // a different road
+        state.legal_speeds = sweep_tasks[i].road->legal_speeds;
+        state.road = sweep_tasks[i].road;
+        reset_sweep(&state);
+      }
+      profile_region(&job->profile)
+      {
+        (*sweep_solver->solve)(&state,job->final_position);
+      }
+      job->n_moves = state.best.n_moves;
+      job->count = state.count;
+      job->elapsed_time = state.elapsed_time;
+      if(job->positions_offset >= 0L)
+        memcpy(&positions[job->positions_offset],state.best.positions,((size_t)job->n_moves + 1) * sizeof(positions[0]));
+    }
+    // publish the result
+    process_sem(semgid,0,_process_mutex_);
+    job->skipped = skip;
+    if(skip == 0 && job->elapsed_time >= _time_limit_ && job->final_position < sh->limit_position)
+      sh->limit_position = job->final_position;
+    job->state = 2;
+    process_sem(semgid,1,_process_mutex_);
+    process_sem(semgid,1,_process_results_);
+  }
+  free_solver_state(&state);
+  close_counters();
+}
+
+static void run_processes(void (*print_task)(sweep_task_t *task))
+{ // solve all tasks of sweep_tasks[] in n_processes child processes and call print_task() for each one of them, in order
+  pid_t pids[_max_processes_];
+  process_shared_t *sh;
+  sweep_task_t *task;
+  process_job_t *job;
+  size_t size;
+  int *positions,shmid,semgid,i,window,slot_size,done,status;
+
+  // the shared data (the shared memory block is marked for destruction at once, so that it goes away with the processes)
+  window = _process_window_ * n_processes;
+  slot_size = 0;
+  for(i = 0;i < n_sweep_tasks;i++)
+    if((sweep_tasks[i].print_this_one != 0 || solution_log != NULL) && sweep_tasks[i].final_position + 1 > slot_size)
+      slot_size = sweep_tasks[i].final_position + 1;
+  size = sizeof(process_shared_t) + (size_t)n_sweep_tasks * sizeof(process_job_t) + (size_t)window * (size_t)slot_size * sizeof(int);
+  if(size > (size_t)UINT32_MAX || (shmid = shmemCreate(IPC_PRIVATE,(unsigned int)size)) == -1 || shmemAttach(shmid,(void **)&sh) == -1)
+  {
+    perror("run_processes: shared memory");
+    exit(1);
+  }
+  (void)shmemDestroy(shmid);
+  if((semgid = semCreate(IPC_PRIVATE,3)) == -1)
+  {
+    perror("run_processes: semaphores");
+    exit(1);
+  }
+  process_semgid = semgid;
+  signal(SIGINT,process_interrupted);
+  signal(SIGTERM,process_interrupted);
+  sh->n_jobs = n_sweep_tasks;
+  sh->next_job = 0;
+  sh->limit_position = INT32_MAX;
+  sh->window = window;
+  sh->n_consumed = 0;
+  sh->n_waiting = 0;
+  positions = (int *)&sh->jobs[n_sweep_tasks];
+  for(i = 0;i < n_sweep_tasks;i++)
+  {
+    job = &sh->jobs[i];
+    memset(job,0,sizeof(*job));
+    job->seed = sweep_tasks[i].road->seed;
+    job->final_position = sweep_tasks[i].final_position;
+    job->positions_offset = -1L;
+    if(sweep_tasks[i].print_this_one != 0 || solution_log != NULL)
+      job->positions_offset = (long)(i % window) * (long)slot_size;
+  }
+  process_sem(semgid,1,_process_mutex_); // green
+  // the worker processes
+  fflush(stdout);
+  fflush(stderr);
+  for(i = 0;i < n_processes;i++)
+  {
+    pids[i] = fork();
+    if(pids[i] < 0)
+    {
+      perror("run_processes: fork");
+      exit(1);
+    }
+    if(pids[i] == 0)
+    {
+      process_worker(sh,semgid,positions);
+      _exit(0); // do not run the atexit() functions of the parent
+    }
+  }
+  // print the results in order, as soon as they become available
+  for(i = 0;i < n_sweep_tasks;i++)
+  {
+    job = &sh->jobs[i];
+    do
+    {
+      process_sem(semgid,0,_process_mutex_);
+      done = (job->state == 2) ? 1 : 0;
+      process_sem(semgid,1,_process_mutex_);
+      if(done == 0)
+        process_sem(semgid,0,_process_results_);
+    }
+    while(done == 0);
+    task = &sweep_tasks[i];
+    task->skipped = job->skipped;
+    task->n_moves = job->n_moves;
+    task->count = job->count;
+    task->elapsed_time = job->elapsed_time;
+    task->profile = job->profile;
+    task->done = 1;
+    if(job->skipped == 0 && job->positions_offset >= 0L)
+    {
+      task->positions = (int *)alloc_memory((size_t)task->n_moves + 1,sizeof(task->positions[0]));
+      memcpy(task->positions,&positions[job->positions_offset],((size_t)task->n_moves + 1) * sizeof(task->positions[0]));
+    }
+    // the slot of this job is free
+    process_sem(semgid,0,_process_mutex_);
+    sh->n_consumed = i + 1;
+    for(;sh->n_waiting > 0;sh->n_waiting--)
+      process_sem(semgid,1,_process_slots_);
+    process_sem(semgid,1,_process_mutex_);
+    (*print_task)(task);
+  }
+  // clean up
+  for(i = 0;i < n_processes;i++)
+    if(waitpid(pids[i],&status,0) != pids[i] || !WIFEXITED(status) || WEXITSTATUS(status) != 0)
+      fprintf(stderr,"run_processes: worker process %d did not terminate normally\n",i);
+  signal(SIGINT,SIG_DFL);
+  signal(SIGTERM,SIG_DFL);
+  (void)semDestroy(semgid);
+  process_semgid = -1;
+  (void)shmemDettach(sh);
+}
+
+#endif
+
+static void run_tasks(void (*print_task)(sweep_task_t *task))
+{ // solve all tasks of sweep_tasks[] and call print_task() for each one of them, in order
+  pthread_t threads[_max_threads_];
+  solver_state_t state;
+  int i;
+
+  limit_position = INT32_MAX;
+  time_used = 0.0;
+#if _use_processes_ > 0
+  if(n_processes > 0)
+  { // child processes
+    run_processes(print_task);
+    return;
+  }
+#endif
+  if(n_threads <= 0)
+  { // sequential
+    init_solver_state(&state,sweep_tasks[0].road);
+    for(i = 0;i < n_sweep_tasks;i++)
+    {
+      run_task(&state,&sweep_tasks[i]);
+      (*print_task)(&sweep_tasks[i]);
+    }
+    free_solver_state(&state);
+    return;
+  }
+  // parallel (the tasks are dealt in turn to the deques of the threads)
+  for(i = 0;i < n_threads;i++)
+  {
+    pthread_mutex_init(&task_deques[i].lock,NULL);
+    task_deques[i].tasks = (int *)alloc_memory((size_t)n_sweep_tasks / (size_t)n_threads + 1,sizeof(int));
+    task_deques[i].head = task_deques[i].tail = 0;
+  }
+  for(i = 0;i < n_sweep_tasks;i++)
+    task_deques[i % n_threads].tasks[task_deques[i % n_threads].tail++] = i;
+  for(i = 0;i < n_threads;i++)
+    if(pthread_create(&threads[i],NULL,sweep_worker,(void *)(intptr_t)i) != 0)
+    {
+      fprintf(stderr,"run_tasks: unable to create thread %d\n",i);
+      exit(1);
+    }
+  // print the results in order, as soon as they become available
+  for(i = 0;i < n_sweep_tasks;i++)
+  {
+    pthread_mutex_lock(&sweep_lock);
+    while(sweep_tasks[i].done == 0)
+      pthread_cond_wait(&sweep_task_done,&sweep_lock);
+    pthread_mutex_unlock(&sweep_lock);
+    (*print_task)(&sweep_tasks[i]);
+  }
+  for(i = 0;i < n_threads;i++)
+  {
+    pthread_join(threads[i],NULL);
+    pthread_mutex_destroy(&task_deques[i].lock);
+    free(task_deques[i].tasks);
+  }
+}
+
+static void free_tasks(void)
+{
+  int i;
+
+  for(i = 0;i < n_sweep_tasks;i++)
+    free(sweep_tasks[i].positions);
+  free(sweep_tasks);
+  sweep_tasks = NULL;
+  n_sweep_tasks = 0;
+}
+
+static void print_sweep_task(sweep_task_t *task)
+{
+  char file_name[64];
+  int i;
+
+  if(task->skipped == 0 && solution_log != NULL)
+    write_solution_record(solution_log,sweep_solver->name,task->final_position,task->n_moves,task->positions,task->count,task->elapsed_time);
+  if(task->print_this_one == 0)
+  { // the positions were only needed for the log
+    free(task->positions);
+    task->positions = NULL;
+  }
+  if(task->skipped == 0 && task->print_this_one != 0)
+  {
+    sprintf(file_name,"%03d_%s.pdf",task->final_position,sweep_solver->pdf_suffix);
+    queue_pdf(file_name,task->final_position,&task->road->max_road_speed[0],task->n_moves,&task->positions,task->elapsed_time,task->count,sweep_solver->title);
+  }
+  trace_begin("output",task->final_position);
+  printf(" │%3d │",task->final_position);
+  if(task->skipped == 0)
+  {
+    printf(" %8d │ %8lu │ %9.3e │",task->n_moves,task->count,task->elapsed_time);
+    if(show_profile != 0)
+    {
+      printf(" %9.3e │",task->profile.wall_time);
+      for(i = 0;i < profile_n_counters;i++)
+        if(task->profile.valid & (1 << i))
+          printf(" %9.3e │",task->profile.counters[i]);
+        else
+          printf("         - │");
+    }
+  }
+  else
+  {
+    if(task->skipped == 2)
+      printf("  skipped │ forecast │ %9.3e │",task->predicted_time);
+    else
+      printf("  skipped │          │           │");
+    if(show_profile != 0)
+      printf("                                                                         │");
+  }
+  printf("\n");
+  fflush(stdout);
+  trace_end("output",task->final_position);
+}
+
+static void run_sweep(void)
+{
+  int i,final_position;
+
+  // create the tasks
+  n_sweep_tasks = 0;
+  for(final_position = 1;final_position <= max_road_size;final_position = next_final_position(final_position))
+  {
+    n_sweep_tasks++;
+    if(final_position == INT32_MAX)
+      break;
+  }
+  sweep_tasks = (sweep_task_t *)alloc_memory((size_t)n_sweep_tasks,sizeof(sweep_tasks[0]));
+  for(i = 0,final_position = 1;i < n_sweep_tasks;i++,final_position = next_final_position(final_position))
+  {
+    sweep_tasks[i].road = &road;
+    sweep_tasks[i].final_position = final_position;
+    sweep_tasks[i].print_this_one = (final_position == 10 || final_position == 20 || final_position == 50 || final_position == 100 || final_position == 200 || final_position == 400 || final_position == 800) ? 1 : 0;
+    if(i == n_sweep_tasks - 1 && final_position > 800) // the largest one (beyond the spiral of the PDF figure, each cell shows a band of the road)
+      sweep_tasks[i].print_this_one = 1;
+  }
+  // solve them
+  if(show_profile == 0)
+  {
+    printf("      ╭─────────────────────────────────╮\n");
+    printf("      │ %31s │\n",sweep_solver->title);
+    printf(" ╭────┼──────────┬──────────┬───────────┤\n");
+    printf(" │  n │ sol      │    count │  cpu time │\n");
+    printf(" │────┼──────────┼──────────┼───────────┤\n");
+    run_tasks(print_sweep_task);
+    printf(" ╰────┴──────────┴──────────┴───────────╯\n");
+  }
+  else
+  {
+    printf("      ╭─────────────────────────────────────────────────────────────────────────────────────────────────────────────╮\n");
+    printf("      │ %107s │\n",sweep_solver->title);
+    printf(" ╭────┼──────────┬──────────┬───────────┬───────────┬───────────┬───────────┬───────────┬───────────┬───────────┤\n");
+    printf(" │  n │ sol      │    count │  cpu time │ wall time │    cycles │    instrs │ br misses │ L1d miss  │ LLC miss  │\n");
+    printf(" │────┼──────────┼──────────┼───────────┼───────────┼───────────┼───────────┼───────────┼───────────┼───────────┤\n");
+    run_tasks(print_sweep_task);
+    printf(" ╰────┴──────────┴──────────┴───────────┴───────────┴───────────┴───────────┴───────────┴───────────┴───────────╯\n");
+  }
+  free_tasks();
+}
+
+
+//
+// batch mode: solve final_position = max_road_size for many n_mec values (seeds) in one process
+//
+//  Os n_mec são dados por um intervalo (primeiro-último) ou por um ficheiro com um n_mec por
+// linha. Além da tabela com o resultado de cada n_mec, são calculados o mínimo, a mediana e o
+// percentil 99 (pelo método do rank mais próximo) do número de movimentos, do esforço e do tempo
+// de CPU. O resumo é escrito em CSV, ou em JSON se o nome do ficheiro acabar em .json.
+//
+
+static int read_seeds(const char *seeds,int **seed_list)
+{
+  int first,last,n,max_n,seed,i;
+  char extra;
+  FILE *fp;
+
+  if(sscanf(seeds,"%d-%d%c",&first,&last,&extra) == 2)
+  { // a range
+    if(last < first)
+      return -1;
+    n = last - first + 1;
+    *seed_list = (int *)alloc_memory((size_t)n,sizeof(int));
+    for(i = 0;i < n;i++)
+      (*seed_list)[i] = first + i;
+    return n;
+  }
+  // a file
+  fp = fopen(seeds,"r");
+  if(fp == NULL)
+  {
+    fprintf(stderr,"read_seeds: unable to open file %s\n",seeds);
+    exit(1);
+  }
+  n = max_n = 0;
+  *seed_list = NULL;
+  while(fscanf(fp,"%d",&seed) == 1)
+  {
+    if(n == max_n)
+    {
+      max_n = 16 + 2 * max_n;
+      *seed_list = (int *)realloc(*seed_list,(size_t)max_n * sizeof(int));
+      if(*seed_list == NULL)
+      {
+        fprintf(stderr,"read_seeds: out of memory\n");
+        exit(1);
+      }
+    }
+    (*seed_list)[n++] = seed;
+  }
+  fclose(fp);
+  return (n > 0) ? n : -1;
+}
+
+static int compare_doubles(const void *a,const void *b)
+{
+  double x = *(const double *)a,y = *(const double *)b;
+
+  return (x < y) ? -1 : (x > y) ? 1 : 0;
+}
+
+static void batch_statistics(double *data,int n,double *min,double *median,double *p99)
+{ // sorts data[]; nearest-rank percentiles
+  qsort(data,(size_t)n,sizeof(data[0]),compare_doubles);
+  *min = data[0];
+  *median = data[(n + 1) / 2 - 1];
+  *p99 = data[(99 * n + 99) / 100 - 1];
+}
+
+static void print_batch_task(sweep_task_t *task)
+{
+  if(solution_log != NULL)
+  { // each seed has its own road
+    write_road_record(solution_log,task->road->seed,max_road_size,_min_road_speed_,_max_road_speed_,task->road->max_road_speed);
+    if(task->skipped == 0)
+      write_solution_record(solution_log,sweep_solver->name,task->final_position,task->n_moves,task->positions,task->count,task->elapsed_time);
+    free(task->positions);
+    task->positions = NULL;
+  }
+  trace_begin("output",task->final_position);
+  printf(" │%10d │ %8d │ %12lu │ %9.3e │\n",task->road->seed,task->n_moves,task->count,task->elapsed_time);
+  fflush(stdout);
+  trace_end("output",task->final_position);
+}
+
+static void run_batch(const char *seeds,const char *summary_file_name)
+{
+  static const char *stat_names[3] = { "n_moves","effort","cpu_time" };
+  double *data,stats[3][3];
+  char title[64];
+  road_t *roads;
+  int *seed_list,n_seeds,i,j,json;
+  FILE *fp;
+
+  n_seeds = read_seeds(seeds,&seed_list);
+  if(n_seeds < 1)
+  {
+    fprintf(stderr,"run_batch: bad list of seeds %s\n",seeds);
+    exit(1);
+  }
+  // one road and one task per seed (the roads are generated here because random() is not thread safe)
+  roads = (road_t *)alloc_memory((size_t)n_seeds,sizeof(roads[0]));
+  n_sweep_tasks = n_seeds;
+  sweep_tasks = (sweep_task_t *)alloc_memory((size_t)n_sweep_tasks,sizeof(sweep_tasks[0]));
+  for(i = 0;i < n_seeds;i++)
+  {
+    init_road_speeds(&roads[i],seed_list[i]);
+    sweep_tasks[i].road = &roads[i];
+    sweep_tasks[i].final_position = max_road_size;
+  }
+  // solve them
+  sprintf(title,"%s, n = %d",sweep_solver->title,max_road_size);
+  printf(" ╭─────────────────────────────────────────────────╮\n");
+  printf(" │ %47s │\n",title);
+  printf(" ├───────────┬──────────┬──────────────┬───────────┤\n");
+  printf(" │     n_mec │ sol      │        count │  cpu time │\n");
+  printf(" │───────────┼──────────┼──────────────┼───────────┤\n");
+  run_tasks(print_batch_task);
+  // statistics
+  data = (double *)alloc_memory((size_t)n_seeds,sizeof(data[0]));
+  for(j = 0;j < 3;j++)
+  {
+    for(i = 0;i < n_seeds;i++)
+      data[i] = (j == 0) ? (double)sweep_tasks[i].n_moves : (j == 1) ? (double)sweep_tasks[i].count : sweep_tasks[i].elapsed_time;
+    batch_statistics(data,n_seeds,&stats[j][0],&stats[j][1],&stats[j][2]);
+  }
+  printf(" │───────────┼──────────┼──────────────┼───────────┤\n");
+  printf(" │       min │ %8.0f │ %12.0f │ %9.3e │\n",stats[0][0],stats[1][0],stats[2][0]);
+  printf(" │    median │ %8.0f │ %12.0f │ %9.3e │\n",stats[0][1],stats[1][1],stats[2][1]);
+  printf(" │       p99 │ %8.0f │ %12.0f │ %9.3e │\n",stats[0][2],stats[1][2],stats[2][2]);
+  printf(" ╰───────────┴──────────┴──────────────┴───────────╯\n");
+  // summary file
+  if(summary_file_name != NULL)
+  {
+    fp = fopen(summary_file_name,"w");
+    if(fp == NULL)
+    {
+      fprintf(stderr,"run_batch: unable to create file %s\n",summary_file_name);
+      exit(1);
+    }
+    i = (int)strlen(summary_file_name);
+    json = (i >= 5 && strcmp(&summary_file_name[i - 5],".json") == 0) ? 1 : 0;
+    if(json != 0)
+    {
+      fprintf(fp,"{\n  \"solver\": \"%s\",\n  \"final_position\": %d,\n  \"seeds\": [\n",sweep_solver->name,max_road_size);
+      for(i = 0;i < n_seeds;i++)
+        fprintf(fp,"    { \"seed\": %d, \"n_moves\": %d, \"effort\": %lu, \"cpu_time\": %.6e }%s\n",sweep_tasks[i].road->seed,sweep_tasks[i].n_moves,sweep_tasks[i].count,sweep_tasks[i].elapsed_time,(i + 1 < n_seeds) ? "," : "");
+      fprintf(fp,"  ],\n  \"summary\": {\n");
+      for(j = 0;j < 3;j++)
+        fprintf(fp,"    \"%s\": { \"min\": %.6g, \"median\": %.6g, \"p99\": %.6g }%s\n",stat_names[j],stats[j][0],stats[j][1],stats[j][2],(j < 2) ? "," : "");
+      fprintf(fp,"  }\n}\n");
+    }
+    else
+    {
+      fprintf(fp,"record,solver,seed,final_position,n_moves,effort,cpu_time\n");
+      for(i = 0;i < n_seeds;i++)
+        fprintf(fp,"seed,%s,%d,%d,%d,%lu,%.6e\n",sweep_solver->name,sweep_tasks[i].road->seed,max_road_size,sweep_tasks[i].n_moves,sweep_tasks[i].count,sweep_tasks[i].elapsed_time);
+      for(i = 0;i < 3;i++)
+        fprintf(fp,"%s,%s,,%d,%.6g,%.6g,%.6e\n",(i == 0) ? "min" : (i == 1) ? "median" : "p99",sweep_solver->name,max_road_size,stats[0][i],stats[1][i],stats[2][i]);
+    }
+    fclose(fp);
+  }
+  // clean up
+  free(data);
+  free_tasks();
+  for(i = 0;i < n_seeds;i++)
+    free_road(&roads[i]);
+  free(roads);
+  free(seed_list);
+}
+
+
+//
+// benchmark mode (repeated timed trials of one or more solvers, for each final_position of the step schedule)
+//
+//  Cada medição é feita com o estado do solver limpo (reset_sweep), para que os solvers
+// incrementais também resolvam o problema completo em cada tentativa. As primeiras tentativas
+// (warmup) não contam. Os resultados podem ser guardados num ficheiro CSV (lido pelo
+// MatLab/PCBenchmark.m) ou JSON, para comparar versões dos solvers pelos números.
+//
+
+#define _benchmark_time_limit_  10.0  // a solver is dropped for larger final positions once one of its trials takes longer than this
+
+#define _max_bench_solvers_  32
+
+static solver_t *bench_solvers[_max_bench_solvers_];
+static int n_bench_solvers;
+
+static int parse_solvers(const char *names)
+{ // a comma-separated list of solver names, or all
+  char name[16];
+  int i,n;
+
+  n_bench_solvers = 0;
+  while(*names != '\0')
+  {
+    for(n = 0;names[n] != '\0' && names[n] != ',';n++)
+      ;
+    if(n >= (int)sizeof(name) || n_bench_solvers == _max_bench_solvers_)
+      return -1;
+    memcpy(name,names,(size_t)n);
+    name[n] = '\0';
+    names += (names[n] == ',') ? n + 1 : n;
+    if(strcmp(name,"all") == 0)
+    {
+      for(i = 0;i < n_solvers && n_bench_solvers < _max_bench_solvers_;i++)
+        bench_solvers[n_bench_solvers++] = &solvers[i];
+      continue;
+    }
+    for(i = 0;i < n_solvers && strcmp(name,solvers[i].name) != 0;i++)
+      ;
+    if(i == n_solvers)
+      return -1;
+    bench_solvers[n_bench_solvers++] = &solvers[i];
+  }
+  return (n_bench_solvers > 0) ? 0 : -1;
+}
+
+static void run_benchmark(int n_mec,int n_trials,int n_warmup,const char *results_file_name)
+{
+  double *times,min,median,mean,stddev;
+  solver_state_t state;
+  int *active,final_position,i,k,json,first_record;
+  FILE *fp;
+
+  init_road_speeds(&road,n_mec);
+  init_solver_state(&state,&road);
+  if(solution_log != NULL)
+    write_road_record(solution_log,n_mec,max_road_size,_min_road_speed_,_max_road_speed_,road.max_road_speed);
+  times = (double *)alloc_memory((size_t)n_trials,sizeof(times[0]));
+  active = (int *)alloc_memory((size_t)n_bench_solvers,sizeof(active[0]));
+  for(k = 0;k < n_bench_solvers;k++)
+    active[k] = 1;
+  fp = NULL;
+  json = first_record = 0;
+  if(results_file_name != NULL)
+  {
+    fp = fopen(results_file_name,"w");
+    if(fp == NULL)
+    {
+      fprintf(stderr,"run_benchmark: unable to create file %s\n",results_file_name);
+      exit(1);
+    }
+    i = (int)strlen(results_file_name);
+    json = (i >= 5 && strcmp(&results_file_name[i - 5],".json") == 0) ? 1 : 0;
+    if(json != 0)
+      fprintf(fp,"{\n  \"n_mec\": %d,\n  \"trials\": %d,\n  \"warmup\": %d,\n  \"results\": [\n",n_mec,n_trials,n_warmup);
+    else
+      fprintf(fp,"solver,final_position,n_moves,effort,trials,min,median,mean,stddev\n");
+  }
+  printf(" ╭───────┬────────┬──────────┬──────────────┬───────────┬───────────┬───────────╮\n");
+  printf(" │solver │      n │ sol      │        count │   min     │ median    │ stddev    │\n");
+  printf(" │───────┼────────┼──────────┼──────────────┼───────────┼───────────┼───────────┤\n");
+  for(final_position = 1;final_position <= max_road_size;final_position = next_final_position(final_position))
+    for(k = 0;k < n_bench_solvers;k++)
+    {
+      if(active[k] == 0)
+        continue;
+      for(i = -n_warmup;i < n_trials;i++)
+      {
+        reset_sweep(&state);
+        (*bench_solvers[k]->solve)(&state,final_position);
+        if(i >= 0)
+          times[i] = state.elapsed_time;
+        if(state.elapsed_time > _benchmark_time_limit_)
+          active[k] = 0;
+      }
+      for(mean = 0.0,i = 0;i < n_trials;i++)
+        mean += times[i];
+      mean /= (double)n_trials;
+      for(stddev = 0.0,i = 0;i < n_trials;i++)
+        stddev += (times[i] - mean) * (times[i] - mean);
+      stddev = (n_trials > 1) ? sqrt(stddev / (double)(n_trials - 1)) : 0.0;
+      qsort(times,(size_t)n_trials,sizeof(times[0]),compare_doubles);
+      min = times[0];
+      median = (n_trials % 2 != 0) ? times[n_trials / 2] : 0.5 * (times[n_trials / 2 - 1] + times[n_trials / 2]);
+      printf(" │%6s │%7d │ %8d │ %12lu │ %9.3e │ %9.3e │ %9.3e │\n",bench_solvers[k]->name,final_position,state.best.n_moves,state.count,min,median,stddev);
+      fflush(stdout);
+      if(solution_log != NULL) // the solution of the last trial, with the median time
+        write_solution_record(solution_log,bench_solvers[k]->name,final_position,state.best.n_moves,state.best.positions,state.count,median);
+      if(fp != NULL && json != 0)
+        fprintf(fp,"%s    { \"solver\": \"%s\", \"final_position\": %d, \"n_moves\": %d, \"effort\": %lu, \"min\": %.6e, \"median\": %.6e, \"mean\": %.6e, \"stddev\": %.6e }",
+                (first_record++ == 0) ? "" : ",\n",bench_solvers[k]->name,final_position,state.best.n_moves,state.count,min,median,mean,stddev);
+      else if(fp != NULL)
+        fprintf(fp,"%s,%d,%d,%lu,%d,%.6e,%.6e,%.6e,%.6e\n",bench_solvers[k]->name,final_position,state.best.n_moves,state.count,n_trials,min,median,mean,stddev);
+    }
+  printf(" ╰───────┴────────┴──────────┴──────────────┴───────────┴───────────┴───────────╯\n");
+  if(fp != NULL)
+  {
+    if(json != 0)
+      fprintf(fp,"\n  ]\n}\n");
+    fclose(fp);
+  }
+  free(active);
+  free(times);
+  free_solver_state(&state);
+  free_road(&road);
+}
+
+#undef _benchmark_time_limit_
+
+
+//
+// main program
+//
+
+static void usage(char *program_name)
+{
+  fprintf(stderr,"usage: %s [-ex] [-s 1|2|bb|dp|sweep|astar|bidir|bits|rle] [-n max_road_size] [-g step_schedule] [-t time_budget] [-j n_threads] [-m n_processes] [-w n_pdf_threads] [-z level[:strategy[:n_threads]]] [--report report.pdf] [-l solutions.srlog] [-p] [--trace trace.json] [-b first-last|seed_file [-o summary.csv|summary.json]] [-r trials[:warmup] [-o results.csv|results.json]] [n_mec]\n",program_name);
+  fprintf(stderr,"  the default step schedule is 50:1,100:5,200:10,20\n");
+  fprintf(stderr,"  -b solves final_position = max_road_size for each n_mec of the batch\n");
+  fprintf(stderr,"  -t skips the final positions whose predicted solve time exceeds what is left of the budget (in seconds)\n");
+  fprintf(stderr,"  -m solves the tasks of the sweep (or of the batch) in worker processes instead of threads%s\n",(_use_processes_ > 0) ? "" : " (not compiled in)");
+  fprintf(stderr,"  -w sets the number of threads that make the PDF files in the background (0 makes them at once)\n");
+  fprintf(stderr,"  -z sets the compression of the PDF files (level 0 to 9, strategy default|filtered|huffman|rle|fixed, 1 to 3 threads per page, 1 by default) and reports its cost; e.g. -z 6::3\n");
+  fprintf(stderr,"  --report puts all the PDF figures in a single file, one page per (solver, size); -s may then list several solvers\n");
+  fprintf(stderr,"  -l appends the road and the solutions of the sweep, batch (one road per n_mec) or benchmark to a binary log (read it with sr_log)\n");
+  fprintf(stderr,"  --trace writes a Chrome trace (open it in https://ui.perfetto.dev) of the solves, PDF files and table output\n");
+  fprintf(stderr,"  -p adds the wall time and the hardware counters (when available) of each solve to the table\n");
+  fprintf(stderr,"  -r benchmarks the solvers of -s (a comma-separated list, or all) for each final_position\n");
+  exit(1);
+}
+
+int main(int argc,char *argv[argc + 1])
+{
+  char *program_name,*batch_seeds,*summary_file_name,*report_file_name;
+  int n_mec,n_trials,n_warmup,show_pdf_statistics,i;
+
+  // generate the example data
+  if(argc == 2 && argv[1][0] == '-' && argv[1][1] == 'e' && argv[1][2] == 'x')
+  {
+    example();
+    return 0;
+  }
+  // options
+  program_name = argv[0];
+  sweep_solver = &solvers[1];
+  batch_seeds = summary_file_name = report_file_name = NULL;
+  n_trials = n_warmup = show_pdf_statistics = 0;
+  (void)parse_schedule("50:1,100:5,200:10,20");
+  while(argc >= 2 && argv[1][0] == '-')
+  {
+    if(strcmp(argv[1],"-p") == 0)
+    { // show the profile of each solve (the only option without an argument)
+      show_profile = 1;
+      argc--;
+      argv++;
+      continue;
+    }
+    if(argc < 3)
+      usage(argv[0]);
+    if(strcmp(argv[1],"-s") == 0)
+    { // choose the solution method (or methods, in benchmark mode)
+      if(parse_solvers(argv[2]) != 0)
+        usage(argv[0]);
+      sweep_solver = bench_solvers[0];
+    }
+    else if(strcmp(argv[1],"-n") == 0)
+    { // the maximum road size
+      max_road_size = atoi(argv[2]);
+      if(max_road_size < 1)
+        usage(argv[0]);
+    }
+    else if(strcmp(argv[1],"-g") == 0)
+    { // the step schedule
+      if(parse_schedule(argv[2]) != 0)
+        usage(argv[0]);
+    }
+    else if(strcmp(argv[1],"--trace") == 0)
+      init_trace(argv[2]); // record a trace of the run
+    else if(strcmp(argv[1],"-z") == 0)
+    { // the compression of the PDF files
+      if(set_pdf_compression(argv[2]) != 0)
+        usage(argv[0]);
+      show_pdf_statistics = 1;
+    }
+    else if(strcmp(argv[1],"-l") == 0)
+      solution_log = open_solution_log(argv[2]); // the binary solution log
+    else if(strcmp(argv[1],"--report") == 0)
+      report_file_name = argv[2]; // a single multi-page PDF file
+    else if(strcmp(argv[1],"-w") == 0)
+    { // the number of PDF rendering threads
+      n_pdf_threads = atoi(argv[2]);
+      if(n_pdf_threads < 0 || n_pdf_threads > _max_pdf_threads_)
+        usage(argv[0]);
+    }
+    else if(strcmp(argv[1],"-t") == 0)
+    { // the time budget of the sweep
+      time_budget = atof(argv[2]);
+      if(time_budget <= 0.0)
+        usage(argv[0]);
+    }
+    else if(strcmp(argv[1],"-j") == 0)
+    { // the number of worker threads
+      n_threads = atoi(argv[2]);
+      if(n_threads < 1 || n_threads > _max_threads_)
+        usage(argv[0]);
+    }
+    else if(strcmp(argv[1],"-m") == 0)
+    { // the number of worker processes
+      n_processes = atoi(argv[2]);
+      if(_use_processes_ == 0 || n_processes < 1 || n_processes > _max_processes_)
+        usage(argv[0]);
+    }
+    else if(strcmp(argv[1],"-b") == 0)
+      batch_seeds = argv[2]; // batch mode
+    else if(strcmp(argv[1],"-o") == 0)
+      summary_file_name = argv[2]; // batch mode summary or benchmark results
+    else if(strcmp(argv[1],"-r") == 0)
+    { // benchmark mode
+      n_warmup = 1;
+      if(sscanf(argv[2],"%d:%d",&n_trials,&n_warmup) < 1 || n_trials < 1 || n_warmup < 0)
+        usage(argv[0]);
+    }
+    else
+      usage(argv[0]);
+    argc -= 2;
+    argv += 2;
+  }
+  if(n_bench_solvers > 1 && n_trials == 0 && report_file_name == NULL)
+    usage(program_name); // only the benchmark and report modes use more than one solver
+  if(batch_seeds != NULL)
+  {
+    run_batch(batch_seeds,summary_file_name);
+    return 0;
+  }
+  // initialization
+  n_mec = (argc < 2) ? 0xAED2022 : atoi(argv[1]);
+  if(n_trials > 0)
+  {
+    if(n_bench_solvers == 0)
+      bench_solvers[n_bench_solvers++] = sweep_solver;
+    run_benchmark(n_mec,n_trials,n_warmup,summary_file_name);
+    return 0;
+  }
+  init_road_speeds(&road,n_mec);
+  if(solution_log != NULL)
+    write_road_record(solution_log,n_mec,max_road_size,_min_road_speed_,_max_road_speed_,road.max_road_speed);
+  if(report_file_name != NULL)
+    open_report(report_file_name);
+  // run the chosen solution method (or methods, in report mode) for all interesting sizes of the problem
+  if(n_bench_solvers == 0)
+    bench_solvers[n_bench_solvers++] = sweep_solver;
+  for(i = 0;i < n_bench_solvers;i++)
+  {
+    sweep_solver = bench_solvers[i];
+    run_sweep();
+  }
+  if(show_pdf_statistics != 0)
+  { // wait for the PDF files
+    flush_pdf_queue();
+    print_pdf_statistics(stdout);
   }
-  printf(" ╰────┴──────────┴──────────┴───────────╯\n");
+  free_road(&road);
   return 0;
-# undef _time_limit_
 }
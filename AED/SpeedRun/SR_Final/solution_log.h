@@ -0,0 +1,357 @@
+//
+// AED, SpeedRun
+//
+// compact binary log of the solutions of a sweep (written by sol_SpeedRun -l, read by sr_log)
+//
+// the file starts with the 8 bytes "SRLOG01\n", followed by records (all integers are unsigned LEB128 varints)
+//
+//   tag (1 byte)  payload size  payload
+//   'R'           ...           seed (as an unsigned 32-bit number), road_size, min speed, max speed,
+//                               max_road_speed[0..road_size] (4 bits each, the low nibble first)
+//   'S'           ...           solver name size, solver name, final_position, n_moves, effort,
+//                               elapsed time (IEEE 754 double, 8 bytes, little endian), encoding, positions
+//
+// a solution record refers to the last road record before it; the positions are encoded as
+//   encoding 0: the differences positions[k] - positions[k - 1] (the speeds), k = 1..n_moves
+//   encoding 1: the changes of speed (-1, 0, or +1; the speed starts at 0), 2 bits each, 4 per byte, the low bits first
+// encoding 1 is used whenever possible (always, for legal solutions), so a solution of n moves takes about n / 4 bytes
+//
+// like elapsed_time.h, this file must be included in only one source file of a program
+//
+// records are appended and flushed one at a time, so a log can grow over several runs; a truncated last record
+// (e.g. after a crash) is ignored by the reader
+//
+
+#ifndef SOLUTION_LOG_H
+#define SOLUTION_LOG_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define _solution_log_magic_  "SRLOG01\n"
+
+typedef struct
+{
+  uint8_t *data;
+  size_t size;
+  size_t max_size;
+}
+log_buffer_t;
+
+void log_put_byte(log_buffer_t *b,uint8_t byte)
+{
+  if(b->size == b->max_size)
+  {
+    b->max_size = 256 + b->max_size + b->max_size / 2;
+    b->data = (uint8_t *)realloc(b->data,b->max_size);
+    if(b->data == NULL)
+    {
+      fprintf(stderr,"log_put_byte: out of memory\n");
+      exit(1);
+    }
+  }
+  b->data[b->size++] = byte;
+}
+
+void log_put_varint(log_buffer_t *b,uint64_t v)
+{
+  while(v >= 0x80)
+  {
+    log_put_byte(b,(uint8_t)(v | 0x80));
+    v >>= 7;
+  }
+  log_put_byte(b,(uint8_t)v);
+}
+
+int log_get_varint(const uint8_t **p,const uint8_t *end,uint64_t *v)
+{ // returns 0 if all is well
+  int shift;
+
+  *v = 0;
+  for(shift = 0;*p < end && shift < 64;shift += 7)
+  {
+    *v |= (uint64_t)(**p & 0x7F) << shift;
+    if((*(*p)++ & 0x80) == 0)
+      return 0;
+  }
+  return -1;
+}
+
+void write_log_record(FILE *fp,int tag,log_buffer_t *payload)
+{
+  log_buffer_t header = { NULL,0,0 };
+
+  log_put_byte(&header,(uint8_t)tag);
+  log_put_varint(&header,(uint64_t)payload->size);
+  if(fwrite(header.data,1,header.size,fp) != header.size || fwrite(payload->data,1,payload->size,fp) != payload->size || fflush(fp) != 0)
+  {
+    fprintf(stderr,"write_log_record: write error\n");
+    exit(1);
+  }
+  free(header.data);
+  payload->size = 0;
+}
+
+
+//
+// writer
+//
+
+FILE *open_solution_log(const char *file_name)
+{ // opens (or creates) a log to append records to it
+  char magic[8];
+  FILE *fp;
+
+  fp = fopen(file_name,"a+b");
+  if(fp == NULL)
+  {
+    fprintf(stderr,"open_solution_log: unable to open file %s\n",file_name);
+    exit(1);
+  }
+  fseek(fp,0L,SEEK_END);
+  if(ftell(fp) == 0L)
+    fwrite(_solution_log_magic_,1,8,fp);
+  else
+  {
+    rewind(fp);
+    if(fread(magic,1,8,fp) != 8 || memcmp(magic,_solution_log_magic_,8) != 0)
+    {
+      fprintf(stderr,"open_solution_log: %s is not a solution log\n",file_name);
+      exit(1);
+    }
+    fseek(fp,0L,SEEK_END); // writes always go to the end of the file
+  }
+  return fp;
+}
+
+void write_road_record(FILE *fp,int seed,int road_size,int min_speed,int max_speed,const uint8_t max_road_speed[1 + road_size])
+{
+  log_buffer_t b = { NULL,0,0 };
+  int i;
+
+  log_put_varint(&b,(uint64_t)(uint32_t)seed);
+  log_put_varint(&b,(uint64_t)road_size);
+  log_put_varint(&b,(uint64_t)min_speed);
+  log_put_varint(&b,(uint64_t)max_speed);
+  for(i = 0;i <= road_size;i += 2)
+    log_put_byte(&b,(uint8_t)((max_road_speed[i] & 15) | ((i < road_size) ? (max_road_speed[i + 1] & 15) << 4 : 0)));
+  write_log_record(fp,'R',&b);
+  free(b.data);
+}
+
+void write_solution_record(FILE *fp,const char *solver,int final_position,int n_moves,const int positions[1 + n_moves],unsigned long effort,double elapsed_time)
+{
+  log_buffer_t b = { NULL,0,0 };
+  uint64_t bits;
+  int i,k,speed,change,encoding;
+  uint8_t byte;
+
+  log_put_varint(&b,(uint64_t)strlen(solver));
+  for(i = 0;solver[i] != '\0';i++)
+    log_put_byte(&b,(uint8_t)solver[i]);
+  log_put_varint(&b,(uint64_t)final_position);
+  log_put_varint(&b,(uint64_t)n_moves);
+  log_put_varint(&b,(uint64_t)effort);
+  memcpy(&bits,&elapsed_time,sizeof(bits));
+  for(i = 0;i < 8;i++)
+    log_put_byte(&b,(uint8_t)(bits >> (8 * i)));
+  // can the speed changes be used?
+  encoding = 1;
+  for(k = 1,speed = 0;k <= n_moves && encoding != 0;k++)
+  {
+    change = positions[k] - positions[k - 1] - speed;
+    if(change < -1 || change > 1)
+      encoding = 0;
+    speed += change;
+  }
+  log_put_byte(&b,(uint8_t)encoding);
+  if(encoding == 0)
+    for(k = 1;k <= n_moves;k++)
+      log_put_varint(&b,(uint64_t)(uint32_t)(positions[k] - positions[k - 1]));
+  else
+    for(k = 1,speed = 0,byte = 0;k <= n_moves;k++)
+    {
+      change = positions[k] - positions[k - 1] - speed;
+      speed += change;
+      byte |= (uint8_t)((change + 1) << (2 * ((k - 1) & 3)));
+      if((k & 3) == 0 || k == n_moves)
+      {
+        log_put_byte(&b,byte);
+        byte = 0;
+      }
+    }
+  write_log_record(fp,'S',&b);
+  free(b.data);
+}
+
+
+//
+// reader
+//
+
+typedef struct
+{
+  int seed;
+  int road_size;
+  int min_speed;
+  int max_speed;
+  uint8_t *max_road_speed; // positions 0..road_size
+}
+log_road_t;
+
+typedef struct
+{
+  char solver[32];
+  int final_position;
+  int n_moves;
+  int max_n_moves;  // the size of the positions array, minus one
+  int *positions;   // positions 0..n_moves
+  unsigned long effort;
+  double elapsed_time;
+}
+log_solution_t;
+
+typedef struct
+{
+  FILE *fp;
+  log_buffer_t record;
+  long n_bytes;     // the number of bytes read so far
+}
+log_reader_t;
+
+int open_log_reader(log_reader_t *r,const char *file_name)
+{ // returns 0 if all is well
+  char magic[8];
+
+  memset(r,0,sizeof(*r));
+  r->fp = fopen(file_name,"rb");
+  if(r->fp == NULL)
+    return -1;
+  if(fread(magic,1,8,r->fp) != 8 || memcmp(magic,_solution_log_magic_,8) != 0)
+  {
+    fclose(r->fp);
+    return -1;
+  }
+  r->n_bytes = 8L;
+  return 0;
+}
+
+void close_log_reader(log_reader_t *r)
+{
+  fclose(r->fp);
+  free(r->record.data);
+}
+
+int read_log_record(log_reader_t *r,log_road_t *road,log_solution_t *solution)
+{ // returns 'R' (road updated), 'S' (solution updated), 0 (end of the log), or -1 (bad or truncated record)
+  const uint8_t *p,*end;
+  uint64_t v,bits;
+  int c,tag,i,k,speed;
+
+  tag = getc(r->fp);
+  if(tag == EOF)
+    return 0;
+  // the payload size (varint)
+  v = 0;
+  for(i = 0;;i += 7)
+  {
+    if((c = getc(r->fp)) == EOF || i > 56)
+      return -1;
+    v |= (uint64_t)(c & 0x7F) << i;
+    if((c & 0x80) == 0)
+      break;
+  }
+  if(v > (uint64_t)0x40000000)
+    return -1;
+  if(r->record.max_size < (size_t)v)
+  {
+    r->record.max_size = (size_t)v + (size_t)v / 2;
+    r->record.data = (uint8_t *)realloc(r->record.data,r->record.max_size);
+    if(r->record.data == NULL)
+    {
+      fprintf(stderr,"read_log_record: out of memory\n");
+      exit(1);
+    }
+  }
+  if(fread(r->record.data,1,(size_t)v,r->fp) != (size_t)v)
+    return -1;
+  r->n_bytes += 2L + (long)(i / 7) + (long)v;
+  p = r->record.data;
+  end = p + v;
+#define get(x)  do { if(log_get_varint(&p,end,&v) != 0) return -1; (x) = v; } while(0)
+  if(tag == 'R')
+  {
+    get(bits);
+    road->seed = (int)(uint32_t)bits;
+    get(road->road_size);
+    get(road->min_speed);
+    get(road->max_speed);
+    if(road->road_size < 0 || end - p != (road->road_size + 2) / 2)
+      return -1;
+    road->max_road_speed = (uint8_t *)realloc(road->max_road_speed,(size_t)road->road_size + 2);
+    if(road->max_road_speed == NULL)
+    {
+      fprintf(stderr,"read_log_record: out of memory\n");
+      exit(1);
+    }
+    for(i = 0;i <= road->road_size;i += 2,p++)
+    {
+      road->max_road_speed[i] = *p & 15;
+      road->max_road_speed[i + 1] = *p >> 4;
+    }
+    return 'R';
+  }
+  if(tag == 'S')
+  {
+    get(k);
+    if(k >= (int)sizeof(solution->solver) || end - p < k)
+      return -1;
+    memcpy(solution->solver,p,(size_t)k);
+    solution->solver[k] = '\0';
+    p += k;
+    get(solution->final_position);
+    get(solution->n_moves);
+    get(solution->effort);
+    if(end - p < 9 || solution->n_moves < 0)
+      return -1;
+    for(i = 0,bits = 0;i < 8;i++)
+      bits |= (uint64_t)*p++ << (8 * i);
+    memcpy(&solution->elapsed_time,&bits,sizeof(bits));
+    if(solution->n_moves > solution->max_n_moves)
+    {
+      solution->max_n_moves = solution->n_moves + solution->n_moves / 2;
+      solution->positions = (int *)realloc(solution->positions,((size_t)solution->max_n_moves + 1) * sizeof(int));
+      if(solution->positions == NULL)
+      {
+        fprintf(stderr,"read_log_record: out of memory\n");
+        exit(1);
+      }
+    }
+    solution->positions[0] = 0;
+    if(*p++ == 0)
+    {
+      for(k = 1;k <= solution->n_moves;k++)
+      {
+        get(i);
+        solution->positions[k] = solution->positions[k - 1] + i;
+      }
+    }
+    else
+    {
+      if(end - p != (solution->n_moves + 3) / 4)
+        return -1;
+      for(k = 1,speed = 0;k <= solution->n_moves;k++)
+      {
+        speed += (int)((p[(k - 1) >> 2] >> (2 * ((k - 1) & 3))) & 3) - 1;
+        solution->positions[k] = solution->positions[k - 1] + speed;
+      }
+    }
+    return 'S';
+  }
+#undef get
+  return -1; // unknown record
+}
+
+#endif
@@ -0,0 +1,180 @@
+//
+// AED, SpeedRun
+//
+// reader of the binary solution logs made by sol_SpeedRun -l (see solution_log.h)
+//
+// Compile using either
+//   cc -Wall -O2 -pthread -D_use_zlib_=0 sr_log.c -o sr_log -lm
+// or
+//   cc -Wall -O2 -pthread -D_use_zlib_=1 sr_log.c -o sr_log -lm -lz
+//
+// it lists the solutions of a log and, optionally, checks them against their road (-v) and makes their PDF figures
+// again, either one file per solution (-p, with the same names as the sweep) or a single multi-page file (-r)
+//
+
+
+//
+// include files
+//
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include "elapsed_time.h"
+#include "make_custom_pdf.c"
+#include "solution_log.h"
+
+
+//
+// check a solution: it starts at position 0 with speed 0, the speed changes by at most one in each move and is
+// always positive, a move with speed s starting at position p must have max_road_speed[p..p+s] >= s, and the last
+// move ends at final_position with speed 1
+//
+
+static int check_solution(const log_road_t *road,const log_solution_t *solution)
+{ // returns 0 if the solution is legal
+  int k,i,position,speed,new_speed;
+
+  if(solution->final_position > road->road_size || solution->positions[0] != 0)
+    return -1;
+  for(k = 1,speed = 0;k <= solution->n_moves;k++)
+  {
+    position = solution->positions[k - 1];
+    new_speed = solution->positions[k] - position;
+    if(new_speed < 1 || new_speed < speed - 1 || new_speed > speed + 1 || solution->positions[k] > solution->final_position)
+      return -1;
+    for(i = 0;i <= new_speed;i++)
+      if(road->max_road_speed[position + i] < new_speed)
+        return -1;
+    speed = new_speed;
+  }
+  return (solution->positions[solution->n_moves] == solution->final_position && speed == 1) ? 0 : -1;
+}
+
+
+//
+// main program
+//
+
+static void usage(char *program_name)
+{
+  fprintf(stderr,"usage: %s [-v] [-p] [-r report.pdf] [-s solver] [-n final_position] log_file\n",program_name);
+  fprintf(stderr,"  -v checks each solution against its road\n");
+  fprintf(stderr,"  -p makes the PDF figure of each solution (NNN_solver.pdf)\n");
+  fprintf(stderr,"  -r puts the PDF figures of all solutions in a single file\n");
+  fprintf(stderr,"  -s and -n only show the solutions of a solver, or of a final position\n");
+  exit(1);
+}
+
+int main(int argc,char *argv[argc + 1])
+{
+  char *program_name,*report_file_name,*only_solver,file_name[64];
+  int check,make_pdfs,only_final_position,status,n_roads,n_solutions,n_shown,n_bad,n_pages;
+  pdf_report_t *report;
+  log_solution_t solution;
+  log_reader_t reader;
+  log_road_t road;
+  double t;
+
+  // options
+  program_name = argv[0];
+  report_file_name = only_solver = NULL;
+  check = make_pdfs = 0;
+  only_final_position = -1;
+  while(argc >= 3 && argv[1][0] == '-')
+  {
+    if(strcmp(argv[1],"-v") == 0 || strcmp(argv[1],"-p") == 0)
+    { // the options without an argument
+      if(argv[1][1] == 'v')
+        check = 1;
+      else
+        make_pdfs = 1;
+      argc--;
+      argv++;
+      continue;
+    }
+    if(argc < 4)
+      usage(program_name);
+    if(strcmp(argv[1],"-r") == 0)
+      report_file_name = argv[2];
+    else if(strcmp(argv[1],"-s") == 0)
+      only_solver = argv[2];
+    else if(strcmp(argv[1],"-n") == 0)
+      only_final_position = atoi(argv[2]);
+    else
+      usage(program_name);
+    argc -= 2;
+    argv += 2;
+  }
+  if(argc != 2)
+    usage(program_name);
+  if(open_log_reader(&reader,argv[1]) != 0)
+  {
+    fprintf(stderr,"%s: %s is not a solution log\n",program_name,argv[1]);
+    return 1;
+  }
+  report = (report_file_name != NULL) ? open_pdf_report(report_file_name) : NULL;
+  // read the log
+  memset(&road,0,sizeof(road));
+  memset(&solution,0,sizeof(solution));
+  n_roads = n_solutions = n_shown = n_bad = n_pages = 0;
+  t = wall_time();
+  while((status = read_log_record(&reader,&road,&solution)) > 0)
+  {
+    if(status == 'R')
+    {
+      if(n_roads++ > 0)
+        printf(" ╰───────┴───────┴──────────┴──────────┴───────────╯\n");
+      printf("road of n_mec %d (size %d, speeds %d to %d)\n",road.seed,road.road_size,road.min_speed,road.max_speed);
+      printf(" ╭───────┬───────┬──────────┬──────────┬───────────╮\n");
+      printf(" │solver │     n │ sol      │    count │  cpu time │\n");
+      printf(" ├───────┼───────┼──────────┼──────────┼───────────┤\n");
+      continue;
+    }
+    n_solutions++;
+    if(n_roads == 0)
+    {
+      fprintf(stderr,"%s: solution without a road\n",program_name);
+      return 1;
+    }
+    if((only_solver != NULL && strcmp(solution.solver,only_solver) != 0) || (only_final_position >= 0 && solution.final_position != only_final_position))
+      continue;
+    n_shown++;
+    printf(" │%6s │%6d │ %8d │ %8lu │ %9.3e │",solution.solver,solution.final_position,solution.n_moves,solution.effort,solution.elapsed_time);
+    if(check != 0)
+    {
+      if(check_solution(&road,&solution) == 0)
+        printf(" ok");
+      else
+      {
+        printf(" BAD");
+        n_bad++;
+      }
+    }
+    printf("\n");
+    if(make_pdfs != 0)
+    {
+      snprintf(file_name,sizeof(file_name),"%03d_%s.pdf",solution.final_position,solution.solver);
+      make_custom_pdf_file(file_name,solution.final_position,road.max_road_speed,solution.n_moves,solution.positions,solution.elapsed_time,solution.effort,solution.solver);
+    }
+    if(report != NULL)
+      add_pdf_report_page(report,n_pages++,solution.final_position,road.max_road_speed,solution.n_moves,solution.positions,solution.elapsed_time,solution.effort,solution.solver);
+  }
+  t = wall_time() - t;
+  if(n_roads > 0)
+    printf(" ╰───────┴───────┴──────────┴──────────┴───────────╯\n");
+  if(status < 0)
+    fprintf(stderr,"%s: the last record of %s is bad or truncated (ignored)\n",program_name,argv[1]);
+  printf("%d road%s, %d solution%s (%d shown",n_roads,(n_roads == 1) ? "" : "s",n_solutions,(n_solutions == 1) ? "" : "s",n_shown);
+  if(check != 0)
+    printf(", %d bad",n_bad);
+  printf("), %ld bytes, %.3e seconds\n",reader.n_bytes,t);
+  // clean up
+  if(report != NULL)
+    close_pdf_report(report);
+  close_log_reader(&reader);
+  free(road.max_road_speed);
+  free(solution.positions);
+  return (n_bad == 0) ? 0 : 1;
+}
@@ -0,0 +1,903 @@
+//
+// AED, SpeedRun
+//
+// database of benchmark results (the tables printed by the speed run programs) and regression comparer
+//
+// Compile using
+//   cc -Wall -O2 sr_results.c -o sr_results -lm
+//
+// the database is a directory (-d option, sr_results.db by default) with two CSV files (easy to read in MatLab with readtable)
+//   runs.csv     run,machine,commit,source,cpu,n_cpus,system,calibration
+//   results.csv  run,solver,n,sol,count,cpu_time   (solver: the algorithm and road, told apart by the effort, see the parser)
+// where a run is one file of tables; calibration is the time of a fixed workload on the machine of the run (empty when it
+// is not known), and cpu_time / calibration is the normalised time used to compare different machines (the runs of the
+// same machine, e.g. of two commits, are compared using their raw times)
+//
+// commands
+//   import dir...                    the TEST_RESULTS/<machine>/test*.txt tables (the machine data comes from SPECS.txt)
+//   record [-m machine] [-c commit] file|-
+//                                    the output of sol_SpeedRun, with the specs of this machine (/proc/cpuinfo and uname)
+//                                    and the time of the calibration loop (run now)
+//   list                             the runs of the database
+//   compare [-t threshold] [-f min_time] a b
+//                                    compares the runs whose run, machine, or commit contain the text a with those that
+//                                    contain the text b, for each (solver, n), and flags the significant slowdowns of b
+//                                    (the exit status is 2 if there is any)
+//
+//  Para cada (solver, n), os tempos (normalizados quando todas as execuções têm calibração) são comparados pelo teste t
+// de Welch sobre os logaritmos, quando há repetições dos dois lados (p.ex. test0, test1 e test2). Para cada solver é
+// também feito um teste t emparelhado sobre as razões de todos os n. Um abrandamento só é assinalado se for maior do
+// que o limiar (5% por omissão) e significativo a 1%, e só se os tempos forem comparáveis: da mesma máquina, ou
+// normalizados pela calibração (as execuções importadas não a têm, logo entre máquinas diferentes só se mostram as
+// razões). Com a opção -f os tempos muito pequenos (que são quase só ruído) são ignorados.
+//
+
+
+//
+// include files
+//
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <dirent.h>
+#include <sys/stat.h>
+#include <sys/utsname.h>
+#include <unistd.h>
+#include "elapsed_time.h"
+
+
+//
+// the database (kept in memory)
+//
+
+typedef struct
+{
+  char run[128];      // machine/file (imported) or machine/commit/date (recorded)
+  char machine[64];
+  char commit[48];
+  char source[256];   // the file the tables came from
+  char cpu[128];
+  int n_cpus;         // 0 if not known
+  char system[128];   // kernel
+  double calibration; // 0.0 if not known
+}
+run_t;
+
+typedef struct
+{
+  int run;            // index into runs[]
+  char solver[48];
+  int n;
+  int sol;
+  long long count;
+  double cpu_time;
+}
+result_t;
+
+static run_t *runs;
+static int n_runs,max_runs;
+static result_t *results;
+static int n_results,max_results;
+static char *db_dir = "sr_results.db";
+
+static void *grow(void *array,int *max_size,size_t element_size)
+{
+  *max_size = 64 + 2 * *max_size;
+  array = realloc(array,(size_t)*max_size * element_size);
+  if(array == NULL)
+  {
+    fprintf(stderr,"grow: out of memory\n");
+    exit(1);
+  }
+  return array;
+}
+
+static run_t *new_run(void)
+{
+  if(n_runs == max_runs)
+    runs = (run_t *)grow(runs,&max_runs,sizeof(run_t));
+  memset(&runs[n_runs],0,sizeof(run_t));
+  return &runs[n_runs++];
+}
+
+static void add_result(int run,const char *solver,int n,int sol,long long count,double cpu_time)
+{
+  result_t *r;
+
+  if(n_results == max_results)
+    results = (result_t *)grow(results,&max_results,sizeof(result_t));
+  r = &results[n_results++];
+  r->run = run;
+  snprintf(r->solver,sizeof(r->solver),"%s",solver);
+  r->n = n;
+  r->sol = sol;
+  r->count = count;
+  r->cpu_time = cpu_time;
+}
+
+static int find_run(const char *run)
+{
+  int i;
+
+  for(i = 0;i < n_runs;i++)
+    if(strcmp(runs[i].run,run) == 0)
+      return i;
+  return -1;
+}
+
+static void clean_field(char *s)
+{ // commas, quotes and new lines cannot appear in the CSV fields
+  for(;*s != '\0';s++)
+    if(*s == ',' || *s == '"' || *s == '\n' || *s == '\r')
+      *s = (*s == ',') ? ';' : ' ';
+}
+
+static int split_csv(char *line,char *fields[],int max_fields)
+{
+  int n;
+
+  line[strcspn(line,"\r\n")] = '\0';
+  for(n = 0;n < max_fields;)
+  {
+    fields[n++] = line;
+    line = strchr(line,',');
+    if(line == NULL)
+      break;
+    *line++ = '\0';
+  }
+  return n;
+}
+
+static void db_file_name(char *file_name,size_t size,const char *name)
+{
+  snprintf(file_name,size,"%s/%s",db_dir,name);
+}
+
+static void load_db(void)
+{
+  char file_name[512],line[1024],*f[16];
+  run_t *run;
+  FILE *fp;
+  int i;
+
+  db_file_name(file_name,sizeof(file_name),"runs.csv");
+  if((fp = fopen(file_name,"r")) == NULL)
+    return; // empty database
+  while(fgets(line,sizeof(line),fp) != NULL)
+    if(strncmp(line,"run,",4) != 0 && split_csv(line,f,8) == 8)
+    {
+      run = new_run();
+      snprintf(run->run,sizeof(run->run),"%s",f[0]);
+      snprintf(run->machine,sizeof(run->machine),"%s",f[1]);
+      snprintf(run->commit,sizeof(run->commit),"%s",f[2]);
+      snprintf(run->source,sizeof(run->source),"%s",f[3]);
+      snprintf(run->cpu,sizeof(run->cpu),"%s",f[4]);
+      run->n_cpus = atoi(f[5]);
+      snprintf(run->system,sizeof(run->system),"%s",f[6]);
+      run->calibration = atof(f[7]);
+    }
+  fclose(fp);
+  db_file_name(file_name,sizeof(file_name),"results.csv");
+  if((fp = fopen(file_name,"r")) == NULL)
+    return;
+  while(fgets(line,sizeof(line),fp) != NULL)
+    if(strncmp(line,"run,",4) != 0 && split_csv(line,f,6) == 6 && (i = find_run(f[0])) >= 0)
+      add_result(i,f[1],atoi(f[2]),atoi(f[3]),atoll(f[4]),atof(f[5]));
+  fclose(fp);
+}
+
+static void save_db(void)
+{
+  char file_name[512];
+  FILE *fp;
+  int i;
+
+  mkdir(db_dir,0755);
+  db_file_name(file_name,sizeof(file_name),"runs.csv");
+  if((fp = fopen(file_name,"w")) == NULL)
+  {
+    fprintf(stderr,"save_db: unable to create %s\n",file_name);
+    exit(1);
+  }
+  fprintf(fp,"run,machine,commit,source,cpu,n_cpus,system,calibration\n");
+  for(i = 0;i < n_runs;i++)
+  {
+    fprintf(fp,"%s,%s,%s,%s,%s,",runs[i].run,runs[i].machine,runs[i].commit,runs[i].source,runs[i].cpu);
+    if(runs[i].n_cpus > 0)
+      fprintf(fp,"%d",runs[i].n_cpus);
+    fprintf(fp,",%s,",runs[i].system);
+    if(runs[i].calibration > 0.0)
+      fprintf(fp,"%.6e",runs[i].calibration);
+    fprintf(fp,"\n");
+  }
+  fclose(fp);
+  db_file_name(file_name,sizeof(file_name),"results.csv");
+  if((fp = fopen(file_name,"w")) == NULL)
+  {
+    fprintf(stderr,"save_db: unable to create %s\n",file_name);
+    exit(1);
+  }
+  fprintf(fp,"run,solver,n,sol,count,cpu_time\n");
+  for(i = 0;i < n_results;i++)
+    fprintf(fp,"%s,%s,%d,%d,%lld,%.3e\n",runs[results[i].run].run,results[i].solver,results[i].n,results[i].sol,results[i].count,results[i].cpu_time);
+  fclose(fp);
+}
+
+
+//
+// parser of the tables (both the old "  n | sol count cpu time |" and the current " │  n │ sol │ count │ cpu time │" ones)
+//   a line with a single field between the separators, starting with a letter, is the title of a table; a line whose first
+//   four numbers are n, sol, count, and cpu time is a result; everything else is ignored (a table also ends when n does not
+//   increase, because some files have several tables without titles)
+//
+//  O título não identifica o algoritmo: o programa original escrevia "plain recursion" para todos os solvers e alguns
+// ficheiros não têm título. Por isso cada tabela é juntada ao grupo (solver) que tem exatamente o mesmo esforço (count)
+// para todos os n em comum, preferindo o grupo com o mesmo título; se não houver nenhum é criado um grupo novo, com o
+// nome do título (ou "untitled"), acrescentado de " (2)", " (3)", ... se esse nome já for de outro grupo. Assim um grupo
+// só tem resultados do mesmo algoritmo sobre a mesma estrada. As escolhas que não são óbvias são mostradas.
+//
+
+static int solver_in_use(const char *name,int first,int last)
+{ // is name the solver of one of the results first..last-1?
+  int i;
+
+  for(i = first;i < last;i++)
+    if(strcmp(results[i].solver,name) == 0)
+      return 1;
+  return 0;
+}
+
+static void new_solver_name(char *name,size_t size,const char *base,int last)
+{ // base, or base (2), base (3), ... (a name not used by results 0..last-1)
+  int k;
+
+  snprintf(name,size,"%s",base);
+  for(k = 2;solver_in_use(name,0,last) != 0;k++)
+    snprintf(name,size,"%.32s (%d)",base,k);
+}
+
+static void end_table(int run,const char *title,int first)
+{ // choose the solver of the results first..n_results-1 (a table)
+  char best[48],name[48];
+  int i,j,max_n,common,best_common,best_title,consistent;
+  long long *count_of_n;
+
+  if(first == n_results)
+    return;
+  // the effort of each n of the table
+  for(max_n = 0,i = first;i < n_results;i++)
+    if(results[i].n > max_n)
+      max_n = results[i].n;
+  count_of_n = (long long *)malloc((size_t)(max_n + 1) * sizeof(long long));
+  if(count_of_n == NULL)
+  {
+    fprintf(stderr,"end_table: out of memory\n");
+    exit(1);
+  }
+  for(i = 0;i <= max_n;i++)
+    count_of_n[i] = -1ll;
+  for(i = first;i < n_results;i++)
+    count_of_n[results[i].n] = results[i].count;
+  // the groups with the same effort for all n in common (the one with the same title, or else the one with most n in common)
+  best[0] = '\0';
+  best_common = best_title = 0;
+  for(i = 0;i < first;i++)
+    if(solver_in_use(results[i].solver,0,i) == 0) // the first result of a group
+    {
+      consistent = 1;
+      common = 0;
+      for(j = i;j < first && consistent != 0;j++)
+        if(strcmp(results[j].solver,results[i].solver) == 0 && results[j].n <= max_n && count_of_n[results[j].n] >= 0ll)
+        {
+          if(results[j].count != count_of_n[results[j].n])
+            consistent = 0;
+          common++;
+        }
+      if(consistent != 0 && common > 0)
+      {
+        j = (strcmp(results[i].solver,(title[0] != '\0') ? title : "untitled") == 0) ? 1 : 0;
+        if(j > best_title || (j == best_title && common > best_common))
+        {
+          snprintf(best,sizeof(best),"%s",results[i].solver);
+          best_common = common;
+          best_title = j;
+        }
+      }
+    }
+  free(count_of_n);
+  if(best[0] == '\0')
+  { // a new group
+    new_solver_name(name,sizeof(name),(title[0] != '\0') ? title : "untitled",first);
+    if(title[0] == '\0')
+      printf("%s: a table without title, filed as \"%s\"\n",runs[run].run,name);
+    else if(strcmp(name,title) != 0)
+      printf("%s: the table \"%s\" has the effort of another algorithm (or road), filed as \"%s\"\n",runs[run].run,title,name);
+  }
+  else if(strncmp(best,"untitled",8) == 0 && title[0] != '\0')
+  { // the first title of a group of tables without title
+    new_solver_name(name,sizeof(name),title,first);
+    printf("%s: the table \"%s\" has the effort of \"%s\", renamed \"%s\"\n",runs[run].run,title,best,name);
+    for(i = 0;i < first;i++)
+      if(strcmp(results[i].solver,best) == 0)
+        snprintf(results[i].solver,sizeof(results[i].solver),"%s",name);
+  }
+  else
+  {
+    snprintf(name,sizeof(name),"%s",best);
+    if(title[0] == '\0')
+      printf("%s: a table without title, filed as \"%s\" (same effort)\n",runs[run].run,name);
+    else if(strcmp(name,title) != 0)
+      printf("%s: the table \"%s\" filed as \"%s\" (same effort)\n",runs[run].run,title,name);
+  }
+  for(i = first;i < n_results;i++)
+    snprintf(results[i].solver,sizeof(results[i].solver),"%s",name);
+}
+
+static int parse_tables(FILE *fp,int run)
+{ // returns the number of results
+  char line[4096],text[4096],*token[8],*s,*t;
+  char title[48];
+  int i,n,n_tokens,n_fields,n_results_found,first,last_n;
+
+  title[0] = '\0';
+  n_results_found = 0;
+  first = n_results;
+  last_n = -1;
+  while(fgets(line,sizeof(line),fp) != NULL)
+  {
+    // replace the box drawing separators (UTF-8 encoded) by '|'
+    for(s = line,t = text;*s != '\0';)
+      if((unsigned char)s[0] == 0xE2 && (unsigned char)s[1] == 0x94 && (unsigned char)s[2] == 0x82)
+      {
+        *t++ = '|';
+        s += 3;
+      }
+      else
+        *t++ = *s++;
+    *t = '\0';
+    if(strchr(text,'|') == NULL)
+      continue;
+    // count the non-empty fields
+    for(n_fields = 0,s = text;s != NULL;s = (t == NULL) ? NULL : t + 1)
+    {
+      t = strchr(s,'|');
+      for(i = 0;s + i != t && s[i] != '\0' && s[i] != '\n';i++)
+        if(s[i] != ' ' && s[i] != '\t')
+        {
+          n_fields++;
+          break;
+        }
+    }
+    // the tokens
+    for(s = text;*s != '\0';s++)
+      if(*s == '|' || *s == '\t' || *s == '\n')
+        *s = ' ';
+    for(n_tokens = 0,s = strtok(text," ");s != NULL && n_tokens < 8;s = strtok(NULL," "))
+      token[n_tokens++] = s;
+    if(n_tokens >= 4 && strspn(token[0],"0123456789") == strlen(token[0]) && strspn(token[1],"0123456789") == strlen(token[1]) &&
+       strspn(token[2],"0123456789") == strlen(token[2]) && strspn(token[3],"0123456789.e+-") == strlen(token[3]))
+    { // a result
+      n = atoi(token[0]);
+      if(n <= last_n)
+      { // another table (with the same title)
+        end_table(run,title,first);
+        first = n_results;
+      }
+      add_result(run,"",n,atoi(token[1]),atoll(token[2]),atof(token[3]));
+      last_n = n;
+      n_results_found++;
+    }
+    else if(n_fields == 1 && n_tokens >= 1 && ((token[0][0] >= 'A' && token[0][0] <= 'Z') || (token[0][0] >= 'a' && token[0][0] <= 'z')))
+    { // a title
+      end_table(run,title,first);
+      first = n_results;
+      last_n = -1;
+      title[0] = '\0';
+      for(i = 0;i < n_tokens;i++)
+        snprintf(title + strlen(title),sizeof(title) - strlen(title),"%s%s",(i == 0) ? "" : " ",token[i]);
+      for(s = title;*s != '\0';s++)
+        if(*s >= 'A' && *s <= 'Z')
+          *s += 'a' - 'A';
+      clean_field(title);
+    }
+  }
+  end_table(run,title,first);
+  return n_results_found;
+}
+
+
+//
+// machine data
+//
+
+static void read_specs(const char *file_name,run_t *run)
+{ // the hand written SPECS.txt files ("    - CPU: ...", "    - Kernel: ...")
+  char line[512],*s;
+  FILE *fp;
+
+  if((fp = fopen(file_name,"r")) == NULL)
+    return;
+  while(fgets(line,sizeof(line),fp) != NULL)
+  {
+    line[strcspn(line,"\r\n")] = '\0';
+    for(s = line;*s == ' ' || *s == '-';s++)
+      ;
+    if(strncmp(s,"CPU: ",5) == 0)
+      snprintf(run->cpu,sizeof(run->cpu),"%s",s + 5);
+    else if(strncmp(s,"Kernel: ",8) == 0)
+      snprintf(run->system,sizeof(run->system),"Linux %s",s + 8);
+  }
+  fclose(fp);
+  clean_field(run->cpu);
+  clean_field(run->system);
+}
+
+static void read_this_machine(run_t *run)
+{ // /proc/cpuinfo and uname()
+  char line[512],*s;
+  struct utsname u;
+  FILE *fp;
+
+  if((fp = fopen("/proc/cpuinfo","r")) != NULL)
+  {
+    while(fgets(line,sizeof(line),fp) != NULL)
+      if(strncmp(line,"processor",9) == 0)
+        run->n_cpus++;
+      else if(run->cpu[0] == '\0' && strncmp(line,"model name",10) == 0 && (s = strchr(line,':')) != NULL)
+      {
+        for(s++;*s == ' ';s++)
+          ;
+        snprintf(run->cpu,sizeof(run->cpu),"%s",s);
+        for(s = run->cpu + strlen(run->cpu);s > run->cpu && (s[-1] == ' ' || s[-1] == '\n');s--)
+          s[-1] = '\0';
+      }
+    fclose(fp);
+  }
+  if(uname(&u) == 0)
+  {
+    snprintf(run->system,sizeof(run->system),"%.31s %.63s %.31s",u.sysname,u.release,u.machine);
+    if(run->machine[0] == '\0')
+      snprintf(run->machine,sizeof(run->machine),"%.63s",u.nodename);
+  }
+  clean_field(run->cpu);
+  clean_field(run->system);
+  clean_field(run->machine);
+}
+
+//
+// the calibration loop: a fixed amount of work of the same kind as the solvers (recursion with data dependent branches
+// over a small road), timed several times; the smallest time is used
+//
+
+static unsigned long calibration_count;
+
+static void calibration_recursion(const unsigned char *speeds,int position,int speed,int final_position)
+{
+  int new_speed,i;
+
+  calibration_count++;
+  for(new_speed = speed + 1;new_speed >= speed - 1;new_speed--)
+    if(new_speed >= 1 && position + new_speed <= final_position)
+    {
+      for(i = 0;i <= new_speed && speeds[position + i] >= new_speed;i++)
+        ;
+      if(i > new_speed && (position + new_speed < final_position || new_speed == 1))
+        calibration_recursion(speeds,position + new_speed,new_speed,final_position);
+    }
+}
+
+static double calibration_time(void)
+{
+  unsigned char speeds[64];
+  double t,best;
+  int i,trial;
+
+  for(i = 0;i < 64;i++)
+    speeds[i] = (unsigned char)(3 + (i * 7 + i / 5) % 7);
+  best = 1.0e30;
+  for(trial = 0;trial < 5;trial++)
+  {
+    calibration_count = 0ul;
+    t = cpu_time();
+    calibration_recursion(speeds,0,0,30);
+    t = cpu_time() - t;
+    if(t < best)
+      best = t;
+  }
+  return best;
+}
+
+
+//
+// commands
+//
+
+static void import_dir(const char *dir)
+{ // dir/<machine>/test*.txt
+  char path[1024],specs[1024],id[128];
+  struct dirent **machines,**files;
+  int i,j,n_machines,n_files,n;
+  run_t *run;
+  FILE *fp;
+
+  n_machines = scandir(dir,&machines,NULL,alphasort);
+  if(n_machines < 0)
+  {
+    fprintf(stderr,"import: unable to read directory %s\n",dir);
+    exit(1);
+  }
+  for(i = 0;i < n_machines;i++)
+  {
+    snprintf(path,sizeof(path),"%s/%s",dir,machines[i]->d_name);
+    n_files = (machines[i]->d_name[0] == '.') ? -1 : scandir(path,&files,NULL,alphasort);
+    for(j = 0;j < n_files;j++)
+    {
+      n = (int)strlen(files[j]->d_name);
+      if(strncmp(files[j]->d_name,"test",4) == 0 && n > 4 && strcmp(files[j]->d_name + n - 4,".txt") == 0)
+      {
+        snprintf(id,sizeof(id),"%.63s/%.*s",machines[i]->d_name,(n - 4 < 63) ? n - 4 : 63,files[j]->d_name);
+        clean_field(id);
+        if(find_run(id) >= 0)
+          printf("%-40s already in the database\n",id);
+        else
+        {
+          snprintf(path,sizeof(path),"%s/%s/%s",dir,machines[i]->d_name,files[j]->d_name);
+          snprintf(specs,sizeof(specs),"%s/%s/SPECS.txt",dir,machines[i]->d_name);
+          if((fp = fopen(path,"r")) == NULL)
+            continue;
+          run = new_run();
+          snprintf(run->run,sizeof(run->run),"%.127s",id);
+          snprintf(run->machine,sizeof(run->machine),"%.63s",machines[i]->d_name);
+          snprintf(run->source,sizeof(run->source),"%.255s",path);
+          clean_field(run->machine);
+          clean_field(run->source);
+          read_specs(specs,run);
+          n = parse_tables(fp,n_runs - 1);
+          fclose(fp);
+          printf("%-40s %5d results\n",id,n);
+        }
+      }
+      free(files[j]);
+    }
+    if(n_files >= 0)
+      free(files);
+    free(machines[i]);
+  }
+  free(machines);
+}
+
+static void record(const char *file_name,const char *machine,const char *commit)
+{
+  char date[32],line[64];
+  time_t now;
+  run_t *run;
+  FILE *fp;
+  int n;
+
+  fp = (strcmp(file_name,"-") == 0) ? stdin : fopen(file_name,"r");
+  if(fp == NULL)
+  {
+    fprintf(stderr,"record: unable to open %s\n",file_name);
+    exit(1);
+  }
+  run = new_run();
+  if(machine != NULL)
+    snprintf(run->machine,sizeof(run->machine),"%s",machine);
+  read_this_machine(run);
+  if(commit == NULL)
+  { // ask git (if this is a git repository)
+    FILE *git = popen("git rev-parse --short HEAD 2>/dev/null","r");
+
+    if(git != NULL)
+    {
+      if(fgets(line,sizeof(line),git) != NULL)
+        snprintf(run->commit,sizeof(run->commit),"%.*s",(int)strcspn(line,"\r\n"),line);
+      pclose(git);
+    }
+  }
+  else
+    snprintf(run->commit,sizeof(run->commit),"%s",commit);
+  clean_field(run->commit);
+  now = time(NULL);
+  strftime(date,sizeof(date),"%Y%m%d-%H%M%S",localtime(&now));
+  snprintf(run->run,sizeof(run->run),"%.63s/%.31s/%.15s",run->machine,(run->commit[0] != '\0') ? run->commit : "-",date);
+  for(n = 2;find_run(run->run) != n_runs - 1;n++) // two runs in the same second
+    snprintf(run->run,sizeof(run->run),"%.63s/%.31s/%.15s-%d",run->machine,(run->commit[0] != '\0') ? run->commit : "-",date,n);
+  snprintf(run->source,sizeof(run->source),"%s",file_name);
+  clean_field(run->source);
+  run->calibration = calibration_time();
+  n = parse_tables(fp,n_runs - 1);
+  if(fp != stdin)
+    fclose(fp);
+  printf("%s: %d results, %s, %d cpus, %s, calibration %.3e seconds\n",run->run,n,run->cpu,run->n_cpus,run->system,run->calibration);
+}
+
+static void list(void)
+{
+  int i,j,n;
+
+  printf("%-40s %-8s %6s %-11s %s\n","run","commit","results","calibration","cpu");
+  for(i = 0;i < n_runs;i++)
+  {
+    for(j = n = 0;j < n_results;j++)
+      n += (results[j].run == i) ? 1 : 0;
+    printf("%-40s %-8s %6d ",runs[i].run,(runs[i].commit[0] != '\0') ? runs[i].commit : "-",n);
+    if(runs[i].calibration > 0.0)
+      printf("%11.3e ",runs[i].calibration);
+    else
+      printf("%11s ","-");
+    printf("%s\n",runs[i].cpu);
+  }
+}
+
+//
+// statistics
+//
+
+static double t_critical(double df)
+{ // two-sided, 1% significance level (the df values between the ones of the table are rounded down)
+  static const double table[][2] =
+  {
+    {  1.0,63.657 },{  2.0,9.925 },{  3.0,5.841 },{  4.0,4.604 },{  5.0,4.032 },{  6.0,3.707 },{  7.0,3.499 },{  8.0,3.355 },
+    {  9.0, 3.250 },{ 10.0,3.169 },{ 12.0,3.055 },{ 15.0,2.947 },{ 20.0,2.845 },{ 30.0,2.750 },{ 60.0,2.660 },{ 1e30,2.576 }
+  };
+  int i;
+
+  for(i = 0;i < 15 && df >= table[i + 1][0];i++)
+    ;
+  return table[i][1];
+}
+
+static void mean_variance(const double *x,int n,double *mean,double *variance)
+{
+  int i;
+
+  *mean = *variance = 0.0;
+  for(i = 0;i < n;i++)
+    *mean += x[i];
+  *mean /= (double)n;
+  for(i = 0;i < n;i++)
+    *variance += (x[i] - *mean) * (x[i] - *mean);
+  *variance = (n > 1) ? *variance / (double)(n - 1) : 0.0;
+}
+
+static int matches(int run,const char *text)
+{
+  return strstr(runs[run].run,text) != NULL || strstr(runs[run].machine,text) != NULL || (runs[run].commit[0] != '\0' && strstr(runs[run].commit,text) != NULL);
+}
+
+static int compare_results(const void *a,const void *b)
+{
+  const result_t *x = (const result_t *)a,*y = (const result_t *)b;
+  int c;
+
+  c = strcmp(x->solver,y->solver);
+  return (c != 0) ? c : x->n - y->n;
+}
+
+static int compare(const char *a,const char *b,double threshold,double min_time)
+{ // returns the number of significant slowdowns
+  double *la,*lb,*ratios,ma,va,mb,vb,se,t,df,r;
+  int i,j,k,na,nb,n_ratios,normalise,same_machine,flag_slowdowns,n_slower,n_runs_a,n_runs_b,n_solvers,mixed,n_mixed;
+  long long count;
+  char flag[16],*machine;
+
+  // which runs? (the times are only normalised when comparing different machines, because the calibration itself is
+  // noisy and only adds noise to comparisons made on the same machine)
+  normalise = 1;
+  same_machine = 1;
+  machine = NULL;
+  n_runs_a = n_runs_b = 0;
+  for(i = 0;i < n_runs;i++)
+    if(matches(i,a) || matches(i,b))
+    {
+      if(matches(i,a) && matches(i,b))
+      {
+        fprintf(stderr,"compare: run %s matches both %s and %s\n",runs[i].run,a,b);
+        exit(1);
+      }
+      n_runs_a += matches(i,a);
+      n_runs_b += matches(i,b);
+      if(runs[i].calibration <= 0.0)
+        normalise = 0;
+      if(machine != NULL && strcmp(machine,runs[i].machine) != 0)
+        same_machine = 0;
+      machine = runs[i].machine;
+    }
+  if(same_machine != 0)
+    normalise = 0;
+  // raw times of different machines only show the differences of the hardware, so they are not flagged
+  flag_slowdowns = (normalise != 0 || same_machine != 0) ? 1 : 0;
+  if(n_runs_a == 0 || n_runs_b == 0)
+  {
+    fprintf(stderr,"compare: no runs match %s\n",(n_runs_a == 0) ? a : b);
+    exit(1);
+  }
+  printf("a = %s (%d run%s), b = %s (%d run%s), %s\n",a,n_runs_a,(n_runs_a == 1) ? "" : "s",b,n_runs_b,(n_runs_b == 1) ? "" : "s",
+         (normalise != 0) ? "times normalised by the calibration loop" : (same_machine != 0) ? "raw times (same machine)" : "raw times (some runs have no calibration)");
+  // a group of results (or a solver) has at most n_results samples
+  la = (double *)malloc((size_t)(n_results + 1) * sizeof(double));
+  lb = (double *)malloc((size_t)(n_results + 1) * sizeof(double));
+  ratios = (double *)malloc((size_t)(n_results + 1) * sizeof(double));
+  if(la == NULL || lb == NULL || ratios == NULL)
+  {
+    fprintf(stderr,"compare: out of memory\n");
+    exit(1);
+  }
+  qsort(results,(size_t)n_results,sizeof(result_t),compare_results);
+  printf(" ╭──────────────────────┬───────┬───────────┬───────────┬────────┬────────┬────────╮\n");
+  printf(" │ solver               │     n │    time a │    time b │  b / a │      t │        │\n");
+  printf(" ├──────────────────────┼───────┼───────────┼───────────┼────────┼────────┼────────┤\n");
+  n_slower = 0;
+  n_ratios = 0;
+  n_solvers = 0;
+  n_mixed = 0;
+  for(i = 0;i < n_results;i = j)
+  {
+    // the results of the same (solver, n), which must have the same effort (databases made before the solvers were
+    // identified by their effort may mix algorithms, or roads, under the same title)
+    na = nb = mixed = 0;
+    count = -1ll;
+    for(j = i;j < n_results && compare_results(&results[i],&results[j]) == 0;j++)
+      if(results[j].cpu_time >= min_time && (matches(results[j].run,a) || matches(results[j].run,b)))
+      {
+        if(count >= 0ll && results[j].count != count)
+          mixed = 1;
+        count = results[j].count;
+        k = results[j].run;
+        r = log(results[j].cpu_time / ((normalise != 0) ? runs[k].calibration : 1.0));
+        if(matches(k,a))
+          la[na++] = r;
+        else if(matches(k,b))
+          lb[nb++] = r;
+      }
+    if(mixed != 0)
+    { // not comparable
+      printf(" │ %-20.20s │ %5d │ %9s │ %9s │ %6s │ %6s │ effort │\n",results[i].solver,results[i].n,"-","-","-","-");
+      n_mixed++;
+    }
+    else if(na > 0 && nb > 0)
+    {
+      mean_variance(la,na,&ma,&va);
+      mean_variance(lb,nb,&mb,&vb);
+      if(n_ratios == 0 && n_solvers++ > 0) // the first row of another solver
+        printf(" ├──────────────────────┼───────┼───────────┼───────────┼────────┼────────┼────────┤\n");
+      ratios[n_ratios++] = mb - ma;
+      strcpy(flag,"");
+      t = 0.0;
+      if(na > 1 && nb > 1)
+      { // Welch's t test
+        se = sqrt(va / (double)na + vb / (double)nb);
+        if(se > 0.0)
+        {
+          t = (mb - ma) / se;
+          df = se * se * se * se / ((va / na) * (va / na) / (double)(na - 1) + (vb / nb) * (vb / nb) / (double)(nb - 1));
+          if(flag_slowdowns != 0 && exp(mb - ma) > 1.0 + threshold && t > t_critical(df))
+          {
+            strcpy(flag,"SLOWER");
+            n_slower++;
+          }
+          else if(flag_slowdowns != 0 && exp(ma - mb) > 1.0 + threshold && -t > t_critical(df))
+            strcpy(flag,"faster");
+        }
+      }
+      printf(" │ %-20.20s │ %5d │ %9.3e │ %9.3e │ %6.3f │ ",results[i].solver,results[i].n,exp(ma),exp(mb),exp(mb - ma));
+      if(na > 1 && nb > 1)
+        printf("%6.2f │ %-6s │\n",fmax(-999.99,fmin(t,999.99)),flag);
+      else
+        printf("     - │        │\n");
+    }
+    // the summary of a solver (paired t test of the log ratios of all n)
+    if(n_ratios > 0 && (j == n_results || strcmp(results[i].solver,results[j].solver) != 0))
+    {
+      mean_variance(ratios,n_ratios,&ma,&va);
+      strcpy(flag,"");
+      t = 0.0;
+      if(n_ratios > 1 && va > 0.0)
+      {
+        t = ma / sqrt(va / (double)n_ratios);
+        if(flag_slowdowns != 0 && exp(ma) > 1.0 + threshold && t > t_critical((double)(n_ratios - 1)))
+        {
+          strcpy(flag,"SLOWER");
+          n_slower++;
+        }
+        else if(flag_slowdowns != 0 && exp(-ma) > 1.0 + threshold && -t > t_critical((double)(n_ratios - 1)))
+          strcpy(flag,"faster");
+      }
+      printf(" │ %-20.20s │   all │ %4d n    │           │ %6.3f │ %6.2f │ %-6s │\n",results[i].solver,n_ratios,exp(ma),fmax(-999.99,fmin(t,999.99)),flag);
+      n_ratios = 0;
+    }
+  }
+  printf(" ╰──────────────────────┴───────┴───────────┴───────────┴────────┴────────┴────────╯\n");
+  if(n_solvers == 0 && n_mixed == 0)
+    printf("no (solver, n) has results of both a and b (the solvers are told apart by their effort, so the runs of different roads are not compared)\n");
+  if(n_mixed > 0)
+    printf("%d (solver, n) not compared: their results have different effort counts (import the runs again)\n",n_mixed);
+  if(flag_slowdowns != 0)
+    printf("%d significant slowdown%s (more than %.0f%%, at the 1%% level)\n",n_slower,(n_slower == 1) ? "" : "s",100.0 * threshold);
+  else
+    printf("slowdowns not flagged: the runs are of different machines and not all of them have a calibration time\n");
+  free(la);
+  free(lb);
+  free(ratios);
+  return n_slower;
+}
+
+
+//
+// main program
+//
+
+static void usage(char *program_name)
+{
+  fprintf(stderr,"usage: %s [-d database_dir] import TEST_RESULTS_dir...\n",program_name);
+  fprintf(stderr,"       %s [-d database_dir] record [-m machine] [-c commit] results.txt|-\n",program_name);
+  fprintf(stderr,"       %s [-d database_dir] list\n",program_name);
+  fprintf(stderr,"       %s [-d database_dir] compare [-t threshold] [-f min_time] a b\n",program_name);
+  exit(1);
+}
+
+int main(int argc,char *argv[argc + 1])
+{
+  char *program_name,*machine,*commit;
+  double threshold,min_time;
+  int i;
+
+  program_name = argv[0];
+  if(argc >= 3 && strcmp(argv[1],"-d") == 0)
+  {
+    db_dir = argv[2];
+    argc -= 2;
+    argv += 2;
+  }
+  if(argc < 2)
+    usage(program_name);
+  load_db();
+  if(strcmp(argv[1],"import") == 0 && argc >= 3)
+  {
+    for(i = 2;i < argc;i++)
+      import_dir(argv[i]);
+    save_db();
+    return 0;
+  }
+  if(strcmp(argv[1],"record") == 0)
+  {
+    machine = commit = NULL;
+    for(argc--,argv++;argc >= 3 && argv[1][0] == '-' && argv[1][1] != '\0';argc -= 2,argv += 2)
+      if(strcmp(argv[1],"-m") == 0)
+        machine = argv[2];
+      else if(strcmp(argv[1],"-c") == 0)
+        commit = argv[2];
+      else
+        usage(program_name);
+    if(argc != 2)
+      usage(program_name);
+    record(argv[1],machine,commit);
+    save_db();
+    return 0;
+  }
+  if(strcmp(argv[1],"list") == 0 && argc == 2)
+  {
+    list();
+    return 0;
+  }
+  if(strcmp(argv[1],"compare") == 0)
+  {
+    threshold = 0.05;
+    min_time = 0.0;
+    for(argc--,argv++;argc >= 3 && argv[1][0] == '-';argc -= 2,argv += 2)
+      if(strcmp(argv[1],"-t") == 0)
+        threshold = atof(argv[2]);
+      else if(strcmp(argv[1],"-f") == 0)
+        min_time = atof(argv[2]);
+      else
+        usage(program_name);
+    if(argc != 3)
+      usage(program_name);
+    return (compare(argv[1],argv[2],threshold,min_time) == 0) ? 0 : 2;
+  }
+  usage(program_name);
+  return 1;
+}